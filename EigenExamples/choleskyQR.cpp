@@ -1,10 +1,17 @@
 #include <cassert>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <Eigen/Dense>
 
+#include "householder_qr.hpp"
+#include "tall_skinny_qr.hpp"
+
 using std::cout;
 using std::endl;
+using std::setw;
 
 using Eigen::MatrixXd;
 using Eigen::VectorXd;
@@ -17,27 +24,14 @@ MatrixXd cholesky(const MatrixXd &A) {
     return A.llt().matrixL();    
 }
 
-/// @brief Function to perform the A = Q * R decomposition via the Cholesky decomposition of A^T * A
-/// @param A is a (m, n) matrix of ``full rank'': rank(A) = n
-/// @param Q is a (m, n) matrix such that Q^T * Q = identity(n)
-/// @param R is a (n, n) upper triangular matrix
-void choleskyQR(const MatrixXd &A, MatrixXd &Q, MatrixXd &R) {
-    LLT<MatrixXd> sol = (A.transpose() * A).llt();
-    MatrixXd L = sol.matrixL();
-    Q = L.triangularView<Eigen::Lower>().solve(A.transpose()).transpose(); // Q = A * (L^{-1}).transpose() = (L^{-1} * A).transpose()
-    R = L.transpose(); // R = L.transpose()
-}
-
-
-/// @brief Function to perform the thin/reduced QR decomposition of matrix A
+/// @brief Function to perform the thin/reduced QR decomposition of matrix A, factoring it once
 /// @param A is an (m, n) matrix
-/// @param Q is a (m, m) matrix such that Q^T * Q = identity(m)
-/// @param R is a (m, n) upper triangular matrix
+/// @param Q is a (m, k) matrix such that Q^T * Q = identity(k), k = min(m, n)
+/// @param R is a (k, n) upper triangular matrix
 void hhQR(const MatrixXd &A, MatrixXd &Q, MatrixXd &R) {
-    Q = A.householderQr().householderQ();
-    R = A.householderQr().matrixQR().triangularView<Eigen::Upper>();
-    // one could also do:??
-    // R = MatrixXd::Identity(std::min(A.rows(), A.cols()), A.rows()) * A.householderQr().matrixQR().triangularView<Eigen::Upper>();
+    BlockedHouseholderQR qr(A);
+    Q = qr.thinQ();
+    R = qr.matrixR();
 }
 
 
@@ -74,7 +68,8 @@ int main()
     MatrixXd Q;
     MatrixXd Rc;
     MatrixXd R;
-    choleskyQR(B, Qc, Rc);
+    bool success = choleskyQR(B, Qc, Rc);
+    assert(success && "CholeskyQR broke down");
     hhQR(B, Q, R);
 
     cout << "B = " << endl;
@@ -95,5 +90,83 @@ int main()
     assert(R.isUpperTriangular() && "R is not upper triangular");
     assert(Rc.isUpperTriangular() && "Rc is not upper triangular");
 
+    // Blocked Householder QR with a partial last panel, against Eigen's
+    {
+        const MatrixXd       C = MatrixXd::Random(1000, 77);
+        const VectorXd       b = VectorXd::Random(1000);
+        BlockedHouseholderQR qr(C, 16);
+        const MatrixXd&      Qt = qr.thinQ();
+        assert((Qt * qr.matrixR()).isApprox(C) && "Blocked Householder QR failed");
+        assert((Qt.transpose() * Qt).isApprox(MatrixXd::Identity(77, 77)) && "Blocked Householder Q is not orthogonal");
+        assert(qr.matrixR().isApprox(MatrixXd(C.householderQr().matrixQR().topRows(77).triangularView<Eigen::Upper>()))
+               && "Blocked Householder R differs from Eigen's");
+
+        // Q^T b without Q: the head is the thin Q^T b, the tail carries the least-squares residual
+        VectorXd qtb = b;
+        qr.applyQTranspose(qtb);
+        const VectorXd x = qr.solve(b);
+        assert(qtb.head(77).isApprox(Qt.transpose() * b) && "Applying Q^T failed");
+        assert(std::abs(qtb.tail(1000 - 77).norm() - (C * x - b).norm()) < 1e-10 && "Q^T b does not carry the residual");
+        assert(x.isApprox(C.householderQr().solve(b)) && "Blocked Householder least squares failed");
+        qr.applyQ(qtb);
+        assert(qtb.isApprox(b) && "Q Q^T is not the identity");
+
+        // Wide matrices factor the leading square block
+        const MatrixXd W = MatrixXd::Random(40, 100);
+        hhQR(W, Q, R);
+        assert((Q * R).isApprox(W) && R.rows() == 40 && "Blocked Householder QR of a wide matrix failed");
+    }
+    cout << "Blocked Householder QR succeeded" << endl;
+
+    // Loss of orthogonality of the tall-skinny modes as the condition number grows: A = U S V^T with
+    // singular values log-spaced from 1 to 1 / kappa
+    {
+        const Eigen::Index rows = 20000, cols = 50;
+        MatrixXd           U    = MatrixXd::Random(rows, cols).householderQr().householderQ() * MatrixXd::Identity(rows, cols);
+        MatrixXd           V    = MatrixXd::Random(cols, cols).householderQr().householderQ();
+
+        const TallSkinnyQRMode modes[] = {TallSkinnyQRMode::CholeskyQR, TallSkinnyQRMode::CholeskyQR2,
+                                          TallSkinnyQRMode::ShiftedCholeskyQR3, TallSkinnyQRMode::TSQR};
+        cout << endl << "Tall-skinny QR of a (" << rows << ", " << cols << ") matrix, |Q^T Q - I|_F / |A - Q R|_F / |A|_F" << endl;
+        cout << setw(8) << "kappa";
+        for (TallSkinnyQRMode mode : modes)
+        {
+            cout << setw(24) << modeName(mode);
+        }
+        cout << endl;
+
+        for (double kappa : {1e2, 1e5, 1e8, 1e12, 1e13, 1e14, 1e15})
+        {
+            const VectorXd sigma = VectorXd::LinSpaced(cols, 0.0, -std::log10(kappa)).unaryExpr([](double e) { return std::pow(10.0, e); });
+            const MatrixXd C     = U * sigma.asDiagonal() * V.transpose();
+            cout << setw(8) << kappa;
+            for (TallSkinnyQRMode mode : modes)
+            {
+                if (!tallSkinnyQR(mode, C, Q, R))
+                {
+                    cout << setw(24) << "breakdown";
+                    continue;
+                }
+                const QRQuality q = qrQuality(C, Q, R);
+                std::ostringstream cell;
+                cell << std::setprecision(2) << q.orthogonality << " / " << q.residual;
+                cout << setw(24) << cell.str();
+
+                assert(q.residual < 1e-13 && "Tall-skinny QR has a large residual");
+                const double bound = mode == TallSkinnyQRMode::CholeskyQR ? 1.0 : 1e-12;
+                assert((mode == TallSkinnyQRMode::CholeskyQR || q.orthogonality < bound) && "Tall-skinny QR lost orthogonality");
+            }
+            cout << endl;
+        }
+
+        // CholeskyQR2 holds up to kappa ~ 1e8, shifted CholeskyQR3 up to ~1e12 at this m n, TSQR beyond
+        const VectorXd sigma = VectorXd::LinSpaced(cols, 0.0, -12.0).unaryExpr([](double e) { return std::pow(10.0, e); });
+        const MatrixXd C     = U * sigma.asDiagonal() * V.transpose();
+        [[maybe_unused]] const bool shiftedOk = shiftedCholeskyQR3(C, Q, R);
+        assert(shiftedOk && qrQuality(C, Q, R).orthogonality < 1e-12 && "Shifted CholeskyQR3 failed at kappa = 1e12");
+        [[maybe_unused]] const bool tsqrOk = tsqr(C, Q, R, 7);
+        assert(tsqrOk && qrQuality(C, Q, R).orthogonality < 1e-12 && "TSQR failed at kappa = 1e12");
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include <Eigen/Dense>
+
+
+/// @brief Householder QR of an (m, n) matrix in the blocked compact-WY form of LAPACK's geqrf. Every panel of
+/// nb columns is factored column by column, and its reflectors H_1 ... H_nb = I - V T V^T are then applied to
+/// the trailing columns in one go with three matrix products, so most of the flops run in GEMM.
+///
+/// The factorization keeps the reflectors, O(m n) memory, and never forms Q: Q^T and Q are applied to vectors or
+/// matrices block by block, and the thin (m, min(m, n)) Q is built only when asked for.
+class BlockedHouseholderQR
+{
+  public:
+    using Matrix = Eigen::MatrixXd;
+    using Vector = Eigen::VectorXd;
+
+    BlockedHouseholderQR() = default;
+
+    /// @brief Constructor that factors A.
+    /// @param A is the matrix.
+    /// @param blockSize is the panel width nb.
+    explicit BlockedHouseholderQR(const Matrix& A, Eigen::Index blockSize = 32)
+    {
+        compute(A, blockSize);
+    }
+
+    /// @brief Factors A = Q R.
+    /// @param A is the matrix.
+    /// @param blockSize is the panel width nb.
+    /// @return *this.
+    BlockedHouseholderQR& compute(const Matrix& A, Eigen::Index blockSize = 32)
+    {
+        const Eigen::Index m = A.rows();
+        const Eigen::Index n = A.cols();
+        const Eigen::Index k = std::min(m, n);
+        QR                   = A;
+        tau.resize(k);
+        T.clear();
+        thinQCache.resize(0, 0);
+        nb = std::max<Eigen::Index>(1, blockSize);
+
+        Vector work(n);
+        for (Eigen::Index j = 0; j < k; j += nb)
+        {
+            const Eigen::Index jb = std::min(nb, k - j);
+
+            // Panel: unblocked Householder, the reflector of column c only updates the panel columns after it
+            for (Eigen::Index c = j; c < j + jb; c++)
+            {
+                double beta;
+                QR.col(c).tail(m - c).makeHouseholderInPlace(tau(c), beta);
+                QR(c, c) = beta;
+                if (c + 1 < j + jb)
+                {
+                    QR.block(c, c + 1, m - c, j + jb - c - 1)
+                        .applyHouseholderOnTheLeft(QR.col(c).tail(m - c - 1), tau(c), work.data());
+                }
+            }
+
+            // Compact-WY factor of the panel, then the trailing columns get (I - V T V^T)^T at once
+            T.push_back(triangularFactor(j, jb));
+            if (j + jb < n)
+            {
+                auto trailing = QR.rightCols(n - j - jb);
+                applyBlock(T.size() - 1, trailing, true);
+            }
+        }
+        return *this;
+    }
+
+    Eigen::Index rows() const { return QR.rows(); }
+    Eigen::Index cols() const { return QR.cols(); }
+
+    /// @return The (min(m, n), n) upper triangular factor.
+    Matrix matrixR() const
+    {
+        const Eigen::Index k = std::min(rows(), cols());
+        return QR.topRows(k).triangularView<Eigen::Upper>();
+    }
+
+    /// @brief Applies Q^T to B in place, block by block, without forming Q. O(m n r) for r columns of B.
+    /// @param B has m rows.
+    template<typename Derived>
+    void applyQTranspose(Eigen::MatrixBase<Derived>& B) const
+    {
+        assert(B.rows() == rows());
+        for (size_t blk = 0; blk < T.size(); blk++)
+        {
+            applyBlock(blk, B, true);
+        }
+    }
+
+    /// @brief Applies Q to B in place, block by block in reverse, without forming Q.
+    /// @param B has m rows.
+    template<typename Derived>
+    void applyQ(Eigen::MatrixBase<Derived>& B) const
+    {
+        assert(B.rows() == rows());
+        for (size_t blk = T.size(); blk-- > 0;)
+        {
+            applyBlock(blk, B, false);
+        }
+    }
+
+    /// @brief The thin Q, (m, min(m, n)), formed by applying Q to the leading columns of the identity on the first
+    /// call and kept afterwards.
+    const Matrix& thinQ() const
+    {
+        if (thinQCache.size() == 0)
+        {
+            thinQCache = Matrix::Identity(rows(), std::min(rows(), cols()));
+            applyQ(thinQCache);
+        }
+        return thinQCache;
+    }
+
+    /// @brief Least-squares solution of min |A x - b|_2 for m >= n and A of full rank: x = R^{-1} (Q^T b)(0:n).
+    /// @param b is the right-hand side.
+    /// @return The solution.
+    Vector solve(const Vector& b) const
+    {
+        assert(rows() >= cols());
+        Vector c = b;
+        applyQTranspose(c);
+        return QR.topRows(cols()).triangularView<Eigen::Upper>().solve(c.head(cols()));
+    }
+
+  private:
+    Matrix              QR;          // R above the diagonal, the essential parts of the reflectors below
+    Vector              tau;         // reflector coefficients
+    std::vector<Matrix> T;           // upper triangular compact-WY factor of each panel
+    Eigen::Index        nb = 32;     // panel width
+    mutable Matrix      thinQCache;  // thin Q, formed on request
+
+    /// @brief The unit lower trapezoidal reflectors of the panel starting at column j, (m - j, jb).
+    Matrix reflectors(Eigen::Index j, Eigen::Index jb) const
+    {
+        Matrix V = QR.block(j, j, rows() - j, jb).triangularView<Eigen::StrictlyLower>();
+        V.topRows(jb).diagonal().setOnes();
+        return V;
+    }
+
+    /// @brief The upper triangular T with H_j ... H_{j + jb - 1} = I - V T V^T, as in LAPACK's larft:
+    /// T(i, i) = tau_i and T(0:i, i) = -tau_i T(0:i, 0:i) V(:, 0:i)^T v_i.
+    Matrix triangularFactor(Eigen::Index j, Eigen::Index jb) const
+    {
+        const Matrix V = reflectors(j, jb);
+        Matrix       F = Matrix::Zero(jb, jb);
+        for (Eigen::Index i = 0; i < jb; i++)
+        {
+            F(i, i) = tau(j + i);
+            if (i > 0)
+            {
+                const Vector w             = V.leftCols(i).transpose() * V.col(i);
+                F.col(i).head(i).noalias() = F.topLeftCorner(i, i).triangularView<Eigen::Upper>() * w;
+                F.col(i).head(i)          *= -tau(j + i);
+            }
+        }
+        return F;
+    }
+
+    /// @brief Applies the block reflector of panel blk, (I - V T V^T)^T if transpose, else I - V T V^T, to B. V is
+    /// read in place, as its unit lower triangular top and the rectangle below.
+    template<typename Derived>
+    void applyBlock(size_t blk, Eigen::MatrixBase<Derived>& B, bool transpose) const
+    {
+        const Eigen::Index j  = static_cast<Eigen::Index>(blk) * nb;
+        const Eigen::Index jb = T[blk].rows();
+        const auto         V1 = QR.block(j, j, jb, jb).triangularView<Eigen::UnitLower>();
+        const auto         V2 = QR.block(j + jb, j, rows() - j - jb, jb);
+        auto               C1 = B.middleRows(j, jb);
+        auto               C2 = B.bottomRows(rows() - j - jb);
+
+        // W has the compile-time shape of B's columns, so a vector B runs matrix-vector kernels
+        Eigen::Matrix<double, Eigen::Dynamic, Derived::ColsAtCompileTime> W = V1.transpose() * C1;
+        W.noalias() += V2.transpose() * C2;
+        if (transpose)
+        {
+            W = T[blk].transpose().triangularView<Eigen::Lower>() * W;
+        }
+        else
+        {
+            W = T[blk].triangularView<Eigen::Upper>() * W;
+        }
+        C2.noalias() -= V2 * W;
+        C1 -= V1 * W;
+    }
+};
@@ -1,8 +1,16 @@
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <Eigen/Dense>
 
+#include "streaming_least_squares.hpp"
+
 using std::cout;
 using std::endl;
 
@@ -12,14 +20,42 @@ using Eigen::Vector2d;
 using Eigen::VectorXd;
 
 /// @brief Function that performes the least squares solution to the overdetermined system Ax = b
-/// via the normal equations
+/// by folding A into a triangular factor R, without the normal equations and their squared condition number
 /// @param A is the matrix of the system
 /// @param x is the vector that will be solved for
 /// @param b is the right hand side of the system
 void leastSquares(const MatrixXd& A, VectorXd& x, const VectorXd& b)
 {
     assert(x.size() == A.cols() && "x must have the same number of elements as A has columns");
-    x = (A.transpose() * A).fullPivLu().solve(A.transpose() * b);
+    StreamingLeastSquares solver(A.cols());
+    solver.addRows(A, b);
+    x = solver.solution();
+}
+
+
+/// @brief Writes noisy samples of a cubic, y = 1 - 2 t + 0.5 t^2 + 3 t^3, as rows [1 t t^2 t^3 y] of doubles, the
+/// layout StreamingLeastSquares reads.
+/// @param path is the file.
+/// @param m is the number of samples.
+/// @param A receives the matrix, for the reference solution.
+/// @param b receives the right-hand side.
+void writeCubicSamples(const char* path, int m, MatrixXd& A, VectorXd& b)
+{
+    const VectorXd t     = VectorXd::LinSpaced(m, -1.0, 1.0);
+    const VectorXd noise = 1e-3 * VectorXd::Random(m);
+    A.resize(m, 4);
+    A.col(0).setOnes();
+    A.col(1) = t;
+    A.col(2) = t.array().square();
+    A.col(3) = t.array().cube();
+    b        = A * Eigen::Vector4d(1.0, -2.0, 0.5, 3.0) + noise;
+
+    std::ofstream out(path, std::ios::binary);
+    for (int i = 0; i < m; i++)
+    {
+        const double row[5] = {A(i, 0), A(i, 1), A(i, 2), A(i, 3), b(i)};
+        out.write(reinterpret_cast<const char*>(row), sizeof(row));
+    }
 }
 
 
@@ -67,5 +103,79 @@ int main()
     cout << "and c = " << endl;
     cout << c << endl;
 
+    // Same answer as the normal equations on this well-conditioned problem
+    const VectorXd xNormal = (A.transpose() * A).fullPivLu().solve(A.transpose() * c);
+    assert((x - xNormal).norm() <= 1e-10 * (1.0 + xNormal.norm()));
+
+    // =========================
+    // Example: fit a cubic to samples that arrive in batches, from a stream and from a memory-mapped file,
+    // and look at the solution while they come in
+    // =========================
+    const char* path = "least_squares_samples.bin";
+    const int   m    = 200000;
+    MatrixXd    S;
+    VectorXd    y;
+    writeCubicSamples(path, m, S, y);
+    const VectorXd reference = S.householderQr().solve(y);
+
+    cout << endl << "Cubic fit to " << m << " samples in batches" << endl;
+    StreamingLeastSquares streamed(4);
+    std::ifstream         in(path, std::ios::binary);
+    for (int batch = 0; in; batch++)
+    {
+        // Batches of 10000 rows read from the stream, with the current solution after some of them
+        if (streamed.addStream(in, 10000) == 0)
+        {
+            break;
+        }
+        if (batch % 5 == 0)
+        {
+            cout << "after " << streamed.rowsSeen() << " rows: x = " << streamed.solution().transpose() << endl;
+        }
+    }
+    assert(streamed.rowsSeen() == m);
+    assert((streamed.solution() - reference).norm() <= 1e-10 * reference.norm());
+    assert(std::abs(streamed.residualNorm() - (S * reference - y).norm()) <= 1e-8 * (S * reference - y).norm());
+
+    StreamingLeastSquares               mapped(4);
+    [[maybe_unused]] const Eigen::Index mappedRows = mapped.addMappedFile(path);
+    assert(mappedRows == m);
+    assert((mapped.solution() - reference).norm() <= 1e-10 * reference.norm());
+    cout << "memory-mapped: x = " << mapped.solution().transpose() << ", residual " << mapped.residualNorm() << endl;
+
+    // The same bytes in two chunks cut inside a row: the cut row is kept over and completed by the second chunk
+    std::ifstream         whole(path, std::ios::binary);
+    const std::string     bytes((std::istreambuf_iterator<char>(whole)), std::istreambuf_iterator<char>());
+    const size_t          cut = 1000 * 5 * sizeof(double) + 13;
+    std::istringstream    first(bytes.substr(0, cut));
+    std::istringstream    second(bytes.substr(cut));
+    StreamingLeastSquares chunked(4);
+    [[maybe_unused]] const Eigen::Index firstRows = chunked.addStream(first);
+    assert(firstRows == 1000 && chunked.partialValues() == 1);
+    chunked.addStream(second);
+    assert(chunked.rowsSeen() == m && chunked.partialValues() == 0);
+    assert((chunked.solution() - reference).norm() <= 1e-10 * reference.norm());
+    std::remove(path);
+
+    // With a forgetting factor lambda the batch j of K counts with weight lambda^(K - 1 - j), the same as a plain
+    // least-squares solve with the rows of that batch scaled by sqrt(lambda^(K - 1 - j))
+    const double          lambda   = 0.9;
+    const int             batchLen = 10000;
+    const int             K        = m / batchLen;
+    StreamingLeastSquares forgetful(4, lambda);
+    MatrixXd              Sw = S;
+    VectorXd              yw = y;
+    for (int j = 0; j < K; j++)
+    {
+        forgetful.addRows(S.middleRows(j * batchLen, batchLen), y.segment(j * batchLen, batchLen));
+        const double weight = std::sqrt(std::pow(lambda, K - 1 - j));
+        Sw.middleRows(j * batchLen, batchLen) *= weight;
+        yw.segment(j * batchLen, batchLen)    *= weight;
+    }
+    const VectorXd weighted = Sw.householderQr().solve(yw);
+    cout << "forgetting factor " << lambda << ": x = " << forgetful.solution().transpose() << endl;
+    assert((forgetful.solution() - weighted).norm() <= 1e-10 * weighted.norm());
+    assert(std::abs(forgetful.residualNorm() - (Sw * weighted - yw).norm()) <= 1e-8 * (Sw * weighted - yw).norm());
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "benchmark_stats.hpp"
+#include "householder_qr.hpp"
+#include "tall_skinny_qr.hpp"
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Prints a line of the table.
+void report(const std::string& name, double seconds, const QRQuality& q)
+{
+    cout << setw(22) << name << setw(12) << seconds << setw(14) << q.orthogonality << setw(14) << q.residual << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    // The regression matrices are m = 1e7, n = 50; the default fits a small machine
+    const Index m = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const Index n = argc > 2 ? std::atol(argv[2]) : 50;
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl;
+#endif
+    cout << "QR of a (" << m << ", " << n << ") matrix" << endl;
+    cout << setw(22) << "method" << setw(12) << "time [s]" << setw(14) << "|Q^T Q - I|" << setw(14) << "residual" << endl;
+
+    const MatrixXd A = MatrixXd::Random(m, n);
+    MatrixXd       Q, R;
+
+    // Best of three runs after one warmup, a run takes seconds at the full size
+    BenchmarkOptions opts;
+    opts.warmup  = 1;
+    opts.minReps = 3;
+    opts.minTime = 0;
+
+    for (TallSkinnyQRMode mode : {TallSkinnyQRMode::CholeskyQR, TallSkinnyQRMode::CholeskyQR2,
+                                  TallSkinnyQRMode::ShiftedCholeskyQR3, TallSkinnyQRMode::TSQR})
+    {
+        const double t = measure([&] { tallSkinnyQR(mode, A, Q, R); }, opts).min;
+        report(modeName(mode), t, qrQuality(A, Q, R));
+    }
+
+    // Reference: Eigen's Householder QR and the thin Q formed from it
+    const double t = measure([&] {
+        Eigen::HouseholderQR<MatrixXd> qr(A);
+        R = qr.matrixQR().topRows(n).triangularView<Eigen::Upper>();
+        Q = qr.householderQ() * MatrixXd::Identity(m, n);
+    }, opts).min;
+    report("Eigen HouseholderQR", t, qrQuality(A, Q, R));
+
+    // Blocked compact-WY Householder: factor once, Q only on request
+    BlockedHouseholderQR qr;
+    const double tBlocked = measure([&] {
+        qr.compute(A);
+        Q = qr.thinQ();
+    }, opts).min;
+    report("Blocked WY + thin Q", tBlocked, qrQuality(A, Q, qr.matrixR()));
+
+    const double    tFactor = measure([&] { qr.compute(A); }, opts).min;
+    Eigen::VectorXd b       = Eigen::VectorXd::Random(m);
+    const double    tApply  = measure([&] { qr.applyQTranspose(b); }, opts).min;
+    cout << endl
+         << "Blocked WY factor only " << tFactor << " s, Q^T b without Q " << tApply << " s; the reflectors take "
+         << 8.0 * m * n / 1e6 << " MB where a full Q would take " << 8.0 * m * m / 1e6 << " MB" << endl;
+
+    return 0;
+}
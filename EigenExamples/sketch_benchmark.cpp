@@ -0,0 +1,115 @@
+#include <cassert>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "benchmark_stats.hpp"
+#include "householder_qr.hpp"
+#include "sketch_least_squares.hpp"
+#include "streaming_least_squares.hpp"
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Backward error measure of a least-squares solution, |A^T r| / (|A|_F |r|), O(u) for a stable method
+/// whatever the condition number, unlike the forward error.
+double normalResidual(const MatrixXd& A, const VectorXd& b, const VectorXd& x)
+{
+    const VectorXd r = b - A * x;
+    return (A.transpose() * r).norm() / (A.norm() * r.norm());
+}
+
+
+/// @brief Prints a line of the table: time, the backward error measure, the difference to the Householder QR
+/// solution and the note.
+void report(const std::string& name, double seconds, double backward, const VectorXd& x, const VectorXd& reference,
+            const std::string& note = "")
+{
+    cout << setw(26) << name << setw(12) << seconds << setw(16) << backward << setw(14)
+         << (x - reference).norm() / reference.norm() << "  " << note << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    // The regression problems have m = 1e6 to 1e8 rows; A alone takes 8 m n bytes, so the default fits a small
+    // machine and larger m go on the command line
+    const Index  m     = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const Index  n     = argc > 2 ? std::atol(argv[2]) : 50;
+    const double kappa = argc > 3 ? std::atof(argv[3]) : 1e6;
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl;
+#endif
+
+    // Columns scaled from 1 to 1 / kappa and mixed by a random rotation, so cond(A) ~ kappa and no diagonal scaling
+    // undoes it; b has a component outside the range of A
+    const VectorXd scaling = VectorXd::LinSpaced(n, 0.0, -std::log10(kappa)).unaryExpr([](double e) { return std::pow(10.0, e); });
+    const MatrixXd V       = MatrixXd::Random(n, n).householderQr().householderQ();
+    const MatrixXd A       = MatrixXd::Random(m, n) * (scaling.asDiagonal() * V.transpose());
+    const VectorXd b       = A * VectorXd::Random(n) + 1e-2 * VectorXd::Random(m);
+    cout << "Least squares with a (" << m << ", " << n << ") matrix, cond ~ " << kappa << ", A takes "
+         << 8.0 * m * n / 1e6 << " MB" << endl;
+    cout << setw(26) << "method" << setw(12) << "time [s]" << setw(16) << "|A^T r|/|A||r|" << setw(14) << "|x - x_qr|"
+         << endl;
+
+    // Best of two runs, the slower first one doubles as the warmup; a run takes seconds at the larger sizes
+    BenchmarkOptions opts;
+    opts.warmup  = 0;
+    opts.minReps = 2;
+    opts.minTime = 0;
+
+    // Reference: Householder QR
+    VectorXd     reference;
+    const double tQR = measure([&] { reference = A.householderQr().solve(b); }, opts).min;
+    const double backwardQR = normalResidual(A, b, reference);
+    report("Eigen HouseholderQR", tQR, backwardQR, reference, reference);
+
+    VectorXd x;
+    // The normal equations as leastSquares used to solve them: A^T A squares kappa, the forward error shows it
+    const double tNormal = measure([&] { x = (A.transpose() * A).fullPivLu().solve(A.transpose() * b); }, opts).min;
+    report("normal equations, LU", tNormal, normalResidual(A, b, x), x, reference);
+
+    const double tBlocked = measure([&] { x = BlockedHouseholderQR(A).solve(b); }, opts).min;
+    report("blocked WY Householder", tBlocked, normalResidual(A, b, x), x, reference);
+
+    const double tStreaming = measure([&] {
+        StreamingLeastSquares solver(n);
+        for (Index r = 0; r < m; r += 8192)
+        {
+            const Index k = std::min<Index>(8192, m - r);
+            solver.addRows(A.middleRows(r, k), b.segment(r, k));
+        }
+        x = solver.solution();
+    }, opts).min;
+    report("streaming R updates", tStreaming, normalResidual(A, b, x), x, reference);
+
+    for (SketchType type : {SketchType::CountSketch, SketchType::SRHT})
+    {
+        SketchOptions options;
+        options.type = type;
+        SketchInfo   info;
+        const double t = measure([&] { info = sketchLeastSquares(A, b, x, options); }, opts).min;
+        const double backward = normalResidual(A, b, x);
+        report(std::string(sketchName(type)) + " + LSQR", t, backward, x, reference,
+               std::to_string(info.iterations) + " iterations");
+        assert(info.converged && backward <= 10 * backwardQR);
+    }
+
+    // Sketch only, to separate the preconditioner from the iterations
+    const Index s = 4 * n;
+    cout << endl
+         << "sketch to (" << s << ", " << n << "): CountSketch " << measure([&] { countSketch(A, s); }, opts).min
+         << " s, SRHT " << measure([&] { srht(A, s); }, opts).min << " s" << endl;
+
+    return 0;
+}
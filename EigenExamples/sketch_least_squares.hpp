@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "tall_skinny_qr.hpp"
+
+
+// Sketch-and-precondition least squares, min |A x - b|_2 for (m, n) A with m >> n, as in Blendenpik and LSRN.
+// A random sketch S A with s = gamma n rows keeps the singular values of A up to a factor close to 1, so the R of
+// a QR of S A makes A R^{-1} well conditioned whatever the condition number of A. LSQR on A R^{-1} y = b then
+// converges in a few dozen iterations, each one product with A and one with A^T, and x = R^{-1} y. The m rows
+// are only streamed through: the sketch and the LSQR products are O(m n), the dense work is O(s n^2). Against the
+// O(m n^2) of a QR this pays off once n is well above the number of LSQR iterations, i.e. from a few hundred columns.
+//
+// Sketches:
+//   CountSketch  every row of A is added, with a random sign, to one random row of S A: one pass, O(m n)
+//   SRHT         random signs, a Walsh-Hadamard transform of every column and s sampled rows: O(m n log m),
+//                but more uniform, so a smaller gamma suffices
+
+
+/// @brief The sketches of this header.
+enum class SketchType
+{
+    CountSketch,
+    SRHT,
+};
+
+
+/// @brief Parameters of sketchLeastSquares.
+struct SketchOptions
+{
+    SketchType type          = SketchType::CountSketch;
+    double     oversampling  = 4.0;    // sketch rows per column, gamma
+    double     tolerance     = 1e-14;  // LSQR stops at |M^T r| <= tolerance |M| |r| for M = A R^{-1}
+    int        maxIterations = 100;
+    uint64_t   seed          = 42;
+};
+
+
+/// @brief What sketchLeastSquares did.
+struct SketchInfo
+{
+    bool   converged    = false;
+    int    iterations   = 0;
+    double residualNorm = 0;  // LSQR's estimate of |A x - b|
+};
+
+
+namespace detail
+{
+
+/// @brief splitmix64, a stateless hash of the row index, so the sketch of a row is the same on every thread.
+inline uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x  = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x  = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/// @brief In-place unnormalized Walsh-Hadamard transform of a power-of-two length.
+inline void walshHadamard(double* x, Eigen::Index n)
+{
+    for (Eigen::Index h = 1; h < n; h *= 2)
+    {
+        for (Eigen::Index i = 0; i < n; i += 2 * h)
+        {
+            for (Eigen::Index j = i; j < i + h; j++)
+            {
+                const double a = x[j];
+                const double b = x[j + h];
+                x[j]           = a + b;
+                x[j + h]       = a - b;
+            }
+        }
+    }
+}
+
+/// @brief y = A x, by row blocks in parallel.
+inline void multiply(const Eigen::MatrixXd& A, const Eigen::VectorXd& x, Eigen::VectorXd& y)
+{
+    const Eigen::Index p = rowBlocks(A.rows(), A.cols());
+    y.resize(A.rows());
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = blockStart(A.rows(), p, k);
+        const Eigen::Index r1 = blockStart(A.rows(), p, k + 1);
+        y.segment(r0, r1 - r0).noalias() = A.middleRows(r0, r1 - r0) * x;
+    }
+}
+
+/// @brief y = A^T x, every thread sums its row block and the n-vectors are added at the end.
+inline void multiplyTransposed(const Eigen::MatrixXd& A, const Eigen::VectorXd& x, Eigen::VectorXd& y)
+{
+    const Eigen::Index           p = rowBlocks(A.rows(), A.cols());
+    std::vector<Eigen::VectorXd> partial(p);
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = blockStart(A.rows(), p, k);
+        const Eigen::Index r1 = blockStart(A.rows(), p, k + 1);
+        partial[k].noalias()  = A.middleRows(r0, r1 - r0).transpose() * x.segment(r0, r1 - r0);
+    }
+    y = partial[0];
+    for (Eigen::Index k = 1; k < p; k++)
+    {
+        y += partial[k];
+    }
+}
+
+}  // namespace detail
+
+
+/// @brief CountSketch S A, (s, n): row i of A goes to row h(i) with sign g(i). One pass over A; every thread
+/// sketches its row block into its own (s, n) matrix, and these are added at the end.
+/// @param A is the (m, n) matrix.
+/// @param s is the number of sketch rows.
+/// @param seed selects the hash; the same seed sketches b consistently with A.
+/// @return The sketch.
+inline Eigen::MatrixXd countSketch(const Eigen::Ref<const Eigen::MatrixXd>& A, Eigen::Index s, uint64_t seed = 42)
+{
+    const Eigen::Index           m = A.rows();
+    const Eigen::Index           n = A.cols();
+    const Eigen::Index           p = detail::rowBlocks(m, n);
+    std::vector<Eigen::MatrixXd> partial(p);
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = detail::blockStart(m, p, k);
+        const Eigen::Index r1 = detail::blockStart(m, p, k + 1);
+        std::vector<Eigen::Index> row(r1 - r0);
+        std::vector<double>       sign(r1 - r0);
+        for (Eigen::Index i = r0; i < r1; i++)
+        {
+            const uint64_t h = detail::splitmix64(seed ^ static_cast<uint64_t>(i));
+            row[i - r0]      = static_cast<Eigen::Index>((h >> 1) % static_cast<uint64_t>(s));
+            sign[i - r0]     = (h & 1) ? 1.0 : -1.0;
+        }
+
+        // Column by column, so A streams and the (s) column of the sketch stays in cache
+        partial[k] = Eigen::MatrixXd::Zero(s, n);
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            const double* a  = A.col(j).data();
+            double*       sa = partial[k].col(j).data();
+            for (Eigen::Index i = r0; i < r1; i++)
+            {
+                sa[row[i - r0]] += sign[i - r0] * a[i];
+            }
+        }
+    }
+    for (Eigen::Index k = 1; k < p; k++)
+    {
+        partial[0] += partial[k];
+    }
+    return partial[0];
+}
+
+
+/// @brief Subsampled randomized Hadamard transform S A = sqrt(1 / s) P H D A, (s, n): D random signs, H the
+/// Walsh-Hadamard transform of the columns zero-padded to a power of two, and P s rows drawn uniformly. The
+/// columns are transformed in parallel, each thread in its own padded buffer.
+/// @param A is the (m, n) matrix.
+/// @param s is the number of sketch rows.
+/// @param seed selects the signs and the rows; the same seed sketches b consistently with A.
+/// @return The sketch.
+inline Eigen::MatrixXd srht(const Eigen::Ref<const Eigen::MatrixXd>& A, Eigen::Index s, uint64_t seed = 42)
+{
+    const Eigen::Index m = A.rows();
+    const Eigen::Index n = A.cols();
+    Eigen::Index       padded = 1;
+    while (padded < m)
+    {
+        padded *= 2;
+    }
+
+    std::vector<Eigen::Index> sampled(s);
+    for (Eigen::Index r = 0; r < s; r++)
+    {
+        sampled[r] = static_cast<Eigen::Index>(detail::splitmix64(~seed ^ static_cast<uint64_t>(r)) % static_cast<uint64_t>(padded));
+    }
+    const double    scale = 1.0 / std::sqrt(static_cast<double>(s));
+    Eigen::MatrixXd SA(s, n);
+
+    #pragma omp parallel
+    {
+        std::vector<double> x(padded);
+
+        #pragma omp for schedule(dynamic)
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            const double* a = A.col(j).data();
+            for (Eigen::Index i = 0; i < m; i++)
+            {
+                x[i] = (detail::splitmix64(seed ^ static_cast<uint64_t>(i)) & 1) ? a[i] : -a[i];
+            }
+            std::fill(x.begin() + m, x.end(), 0.0);
+            detail::walshHadamard(x.data(), padded);
+
+            // H is unnormalized, H^T H = padded I, and sampling s of padded rows scales by padded / s
+            for (Eigen::Index r = 0; r < s; r++)
+            {
+                SA(r, j) = scale * x[sampled[r]];
+            }
+        }
+    }
+    return SA;
+}
+
+
+/// @brief Least-squares solution of min |A x - b|_2 by sketch-and-precondition: R from a QR of the sketch S A,
+/// then LSQR (Paige and Saunders, 1982) on A R^{-1} y = b and x = R^{-1} y.
+///
+/// LSQR starts from the sketch-and-solve solution x0 = argmin |S (A x - b)|, already within a small factor of the
+/// optimal residual, and only computes the correction from b - A x0. The rounding errors of R^{-1}, O(u kappa)
+/// relative to what LSQR computes, then act on a small correction, which keeps the method close to backward
+/// stable (Meier, Nakatsukasa, Townsend and Webb, 2024) where a cold start stalls at O(u kappa).
+/// @param A is the (m, n) matrix of full rank, m >> n.
+/// @param b is the right-hand side.
+/// @param x is the solution on exit.
+/// @param options selects the sketch, its size and the LSQR tolerance.
+/// @return Whether LSQR converged, after how many iterations, and the residual norm.
+inline SketchInfo sketchLeastSquares(const Eigen::MatrixXd& A, const Eigen::VectorXd& b, Eigen::VectorXd& x,
+                                     const SketchOptions& options = {})
+{
+    using Eigen::VectorXd;
+    const Eigen::Index n = A.cols();
+    const Eigen::Index s = std::min<Eigen::Index>(A.rows(), static_cast<Eigen::Index>(std::ceil(options.oversampling * n)));
+    SketchInfo         info;
+
+    // Preconditioner and starting point from the sketch of [A b]
+    auto sketch = [&](const Eigen::Ref<const Eigen::MatrixXd>& B) {
+        return options.type == SketchType::SRHT ? srht(B, s, options.seed) : countSketch(B, s, options.seed);
+    };
+    const Eigen::HouseholderQR<Eigen::MatrixXd> qr(sketch(A));
+    const Eigen::MatrixXd R  = qr.matrixQR().topRows(n).triangularView<Eigen::Upper>();
+    const auto            Rt = R.triangularView<Eigen::Upper>();
+    const VectorXd        x0 = qr.solve(sketch(b));
+
+    // LSQR on M = A R^{-1}: M v = A (R^{-1} v), M^T u = R^{-T} (A^T u)
+    VectorXd u;
+    detail::multiply(A, x0, u);
+    u           = b - u;
+    double beta = u.norm();
+    x           = x0;
+    if (beta == 0.0)
+    {
+        info.converged = true;
+        return info;
+    }
+    u /= beta;
+    VectorXd v;
+    detail::multiplyTransposed(A, u, v);
+    Rt.transpose().solveInPlace(v);
+    double alpha = v.norm();
+    if (alpha == 0.0)
+    {
+        info.converged    = true;
+        info.residualNorm = beta;
+        return info;
+    }
+    v /= alpha;
+
+    VectorXd y = VectorXd::Zero(n), w = v, Mv, tmp;
+    double   phibar = beta, rhobar = alpha, normM2 = alpha * alpha;
+    for (info.iterations = 1; info.iterations <= options.maxIterations; info.iterations++)
+    {
+        // Bidiagonalization step
+        tmp = v;
+        Rt.solveInPlace(tmp);
+        detail::multiply(A, tmp, Mv);
+        u    = Mv - alpha * u;
+        beta = u.norm();
+        if (beta > 0)
+        {
+            u /= beta;
+            detail::multiplyTransposed(A, u, tmp);
+            Rt.transpose().solveInPlace(tmp);
+            v     = tmp - beta * v;
+            alpha = v.norm();
+            if (alpha > 0)
+            {
+                v /= alpha;
+            }
+        }
+        normM2 += alpha * alpha + beta * beta;
+
+        // Givens rotation of the bidiagonal and the update of y and the search direction
+        const double rho   = std::hypot(rhobar, beta);
+        const double c     = rhobar / rho;
+        const double sn    = beta / rho;
+        const double theta = sn * alpha;
+        const double phi   = c * phibar;
+        rhobar             = -c * alpha;
+        phibar             = sn * phibar;
+        y                 += (phi / rho) * w;
+        w                  = v - (theta / rho) * w;
+
+        // |M^T r| = phibar alpha |c|; a consistent system stops on |r| instead
+        const double normMr = phibar * alpha * std::abs(c);
+        if (normMr <= options.tolerance * std::sqrt(normM2) * phibar || phibar <= options.tolerance * b.norm())
+        {
+            info.converged = true;
+            break;
+        }
+    }
+    info.iterations   = std::min(info.iterations, options.maxIterations);
+    info.residualNorm = phibar;
+    x                += Rt.solve(y);
+    return info;
+}
+
+
+/// @brief Name of a sketch for reports.
+inline const char* sketchName(SketchType type)
+{
+    switch (type)
+    {
+    case SketchType::CountSketch:
+        return "CountSketch";
+    case SketchType::SRHT:
+        return "SRHT";
+    }
+    return "";
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/// @brief Least-squares solver min |A x - b|_2 for observations that arrive in row batches, e.g. from a stream or
+/// a file larger than the memory. Only the (n, n) triangular factor R of the rows seen so far and z = (Q^T b)(0:n)
+/// are kept: a batch (A_k, b_k) is folded in by Householder reflectors on the stacked [R z; A_k b_k] that touch
+/// one row of R and the k batch rows each, so R stays triangular and an update costs O(k n^2). The solution
+/// R^{-1} z is available after any batch; nothing ever forms A^T A, so the condition number is not squared.
+///
+/// Rows are stored as n coefficients followed by the right-hand side, both for streams and mapped files.
+class StreamingLeastSquares
+{
+  public:
+    using Matrix = Eigen::MatrixXd;
+    using Vector = Eigen::VectorXd;
+
+    /// @brief Constructor
+    /// @param n is the number of unknowns.
+    /// @param forgetting scales the past by this factor at every batch, 1 keeps all rows with equal weight and
+    /// smaller values track slowly changing solutions, as recursive least squares does.
+    explicit StreamingLeastSquares(Eigen::Index n, double forgetting = 1.0)
+    : R(Matrix::Zero(n, n))
+    , z(Vector::Zero(n))
+    , forgetting(forgetting)
+    {
+    }
+
+    Eigen::Index cols() const { return R.cols(); }
+    Eigen::Index rowsSeen() const { return rows; }
+
+    /// @brief Folds a batch of rows into the factorization, using the batch as workspace.
+    /// @param A is the (k, n) batch of the matrix, overwritten.
+    /// @param b is the (k) batch of the right-hand side, overwritten.
+    template<typename DerivedA, typename DerivedB>
+    void addRowsInPlace(Eigen::MatrixBase<DerivedA>& A, Eigen::MatrixBase<DerivedB>& b)
+    {
+        const Eigen::Index n = cols();
+        assert(A.cols() == n && b.rows() == A.rows());
+        if (forgetting != 1.0)
+        {
+            R          *= std::sqrt(forgetting);
+            z          *= std::sqrt(forgetting);
+            residualSq *= forgetting;
+        }
+
+        Eigen::RowVectorXd w(n);
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            // Reflector on [R(j, j); A(:, j)] that zeroes the batch column
+            const double alpha = R(j, j);
+            const double sigma = A.col(j).squaredNorm();
+            if (sigma == 0.0)
+            {
+                continue;
+            }
+            const double beta = alpha >= 0 ? -std::sqrt(alpha * alpha + sigma) : std::sqrt(alpha * alpha + sigma);
+            const double tau  = (beta - alpha) / beta;
+            A.col(j) /= alpha - beta;  // essential part of v = [1; A(:, j)]
+            R(j, j)   = beta;
+
+            // The rest of row j of R and the batch columns after j, then the right-hand side
+            const Eigen::Index rest = n - j - 1;
+            if (rest > 0)
+            {
+                w.head(rest).noalias()       = A.col(j).transpose() * A.rightCols(rest);
+                w.head(rest)                += R.row(j).tail(rest);
+                w.head(rest)                *= tau;
+                R.row(j).tail(rest)         -= w.head(rest);
+                A.rightCols(rest).noalias() -= A.col(j) * w.head(rest);
+            }
+            const double wb = tau * (z(j) + A.col(j).dot(b));
+            z(j) -= wb;
+            b    -= wb * A.col(j);
+        }
+        // What is left of b is orthogonal to the column space of everything seen
+        residualSq += b.squaredNorm();
+        rows       += A.rows();
+    }
+
+    /// @brief Folds a copy of a batch of rows into the factorization.
+    /// @param A is the (k, n) batch of the matrix.
+    /// @param b is the (k) batch of the right-hand side.
+    template<typename DerivedA, typename DerivedB>
+    void addRows(const Eigen::MatrixBase<DerivedA>& A, const Eigen::MatrixBase<DerivedB>& b)
+    {
+        Matrix Ak = A;
+        Vector bk = b;
+        addRowsInPlace(Ak, bk);
+    }
+
+    /// @brief Reads rows from a binary stream of doubles, n coefficients and the right-hand side per row, until the
+    /// stream ends or maxRows are read. Called repeatedly with a limit, it consumes a continuous stream piece by piece
+    /// with the solution available in between. A read that ends inside a row keeps the values of that row for the
+    /// next call, so a stream can also be fed in chunks that do not align with the rows; partialValues() tells
+    /// whether a stream ended inside a row.
+    /// @param in is the stream.
+    /// @param maxRows is the largest number of rows read in this call.
+    /// @param batchRows is the number of rows read and folded in at once.
+    /// @return The number of rows read.
+    Eigen::Index addStream(std::istream& in, Eigen::Index maxRows = std::numeric_limits<Eigen::Index>::max(),
+                           Eigen::Index batchRows = 4096)
+    {
+        const Eigen::Index  n        = cols();
+        const Eigen::Index  rowBytes = (n + 1) * static_cast<Eigen::Index>(sizeof(double));
+        std::vector<double> buffer(std::min(batchRows, maxRows) * (n + 1));
+        Eigen::Index        total = 0;
+        while (in && total < maxRows)
+        {
+            // The values of a row cut by the previous read go first, the stream fills up the rest of the batch
+            const Eigen::Index want = std::min(batchRows, maxRows - total);
+            const Eigen::Index kept = static_cast<Eigen::Index>(partial.size());
+            char*              bytesBuf = reinterpret_cast<char*>(buffer.data());
+            std::copy(partial.begin(), partial.end(), bytesBuf);
+            in.read(bytesBuf + kept, static_cast<std::streamsize>(want * rowBytes - kept));
+            const Eigen::Index bytes = kept + static_cast<Eigen::Index>(in.gcount());
+            const Eigen::Index k     = bytes / rowBytes;
+            partial.assign(bytesBuf + k * rowBytes, bytesBuf + bytes);
+            if (k == 0)
+            {
+                break;
+            }
+            addRowMajor(buffer.data(), k);
+            total += k;
+        }
+        return total;
+    }
+
+    /// @return The number of values of a row that addStream has read only in part and keeps for the next call, 0
+    /// after whole rows. Nonzero at the end of a stream means the stream was cut inside a row.
+    Eigen::Index partialValues() const { return static_cast<Eigen::Index>(partial.size() / sizeof(double)); }
+
+    /// @brief Maps a binary file of rows, as written for addStream, and folds it in batch by batch. The kernel pages
+    /// the file in as the batches are read and can drop the pages behind them, so the file can exceed the memory.
+    /// A file whose size is not a whole number of rows is cut inside its last row and is rejected.
+    /// @param path is the file.
+    /// @param batchRows is the number of rows folded in at once.
+    /// @return The number of rows read, or -1 if the file cannot be mapped or is cut inside a row.
+    Eigen::Index addMappedFile(const std::string& path, Eigen::Index batchRows = 4096)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        // mmap rejects a length of 0, and an empty file has no rows
+        if (st.st_size == 0)
+        {
+            close(fd);
+            return 0;
+        }
+        const Eigen::Index rowBytes = (cols() + 1) * static_cast<Eigen::Index>(sizeof(double));
+        if (static_cast<Eigen::Index>(st.st_size) % rowBytes != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            return -1;
+        }
+        madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        const Eigen::Index total   = static_cast<Eigen::Index>(st.st_size) / rowBytes;
+        const double*      rowData = static_cast<const double*>(data);
+        for (Eigen::Index r = 0; r < total; r += batchRows)
+        {
+            addRowMajor(rowData + r * (cols() + 1), std::min(batchRows, total - r));
+        }
+        munmap(data, static_cast<size_t>(st.st_size));
+        return total;
+    }
+
+    /// @brief The least-squares solution of the rows seen so far, by back substitution with R.
+    /// @return The solution, needs as many independent rows as unknowns.
+    Vector solution() const
+    {
+        assert(isFullRank() && "Not enough independent rows for a unique solution");
+        return R.triangularView<Eigen::Upper>().solve(z);
+    }
+
+    /// @brief Whether R is nonsingular, i.e. the rows seen so far determine the solution.
+    bool isFullRank() const
+    {
+        const double scale = R.diagonal().cwiseAbs().maxCoeff();
+        return scale > 0 && R.diagonal().cwiseAbs().minCoeff() > 1e3 * std::numeric_limits<double>::epsilon() * scale;
+    }
+
+    /// @return The residual norm |A x - b|_2 of the current solution over all rows seen.
+    double residualNorm() const { return std::sqrt(residualSq); }
+
+    /// @return The (n, n) triangular factor, A^T A = R^T R for the rows seen.
+    const Matrix& matrixR() const { return R; }
+
+  private:
+    Matrix            R;
+    Vector            z;
+    double            forgetting;
+    double            residualSq = 0;
+    Eigen::Index      rows       = 0;
+    std::vector<char> partial;  // bytes of a row cut by the last read of addStream
+
+    /// @brief Copies k row-major rows into column-major batches and folds them in.
+    void addRowMajor(const double* data, Eigen::Index k)
+    {
+        using RowMajor = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        const Eigen::Map<const RowMajor> rowsMap(data, k, cols() + 1);
+        Matrix                           Ak = rowsMap.leftCols(cols());
+        Vector                           bk = rowsMap.col(cols());
+        addRowsInPlace(Ak, bk);
+    }
+};
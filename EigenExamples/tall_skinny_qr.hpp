@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+// QR factorizations A = Q R of tall-skinny matrices, (m, n) with m >> n, returning the thin Q, (m, n), and the
+// upper triangular R, (n, n). All modes split A into row blocks, one per OpenMP thread, so the O(m n^2) work
+// scales across cores while everything of size n x n stays on one thread.
+//
+// Loss of orthogonality |Q^T Q - I| with u the unit roundoff and kappa the condition number of A:
+//   CholeskyQR          O(u kappa^2), breaks down from kappa ~ u^{-1/2}
+//   CholeskyQR2         O(u) up to kappa ~ u^{-1/2}
+//   ShiftedCholeskyQR3  O(u) up to kappa ~ 1e12 for m n = 1e6, lower for larger m n (see shiftedCholeskyQR3)
+//   TSQR                O(u) for any full-rank A
+// The Cholesky modes are two or three GEMM-like passes over A; TSQR does Householder QR of the blocks and
+// merges their R factors in a binary tree.
+
+
+/// @brief The factorizations of this header.
+enum class TallSkinnyQRMode
+{
+    CholeskyQR,
+    CholeskyQR2,
+    ShiftedCholeskyQR3,
+    TSQR,
+};
+
+
+namespace detail
+{
+
+/// @brief Number of row blocks for an (m, n) matrix: one per thread, each with at least n rows.
+inline Eigen::Index rowBlocks(Eigen::Index m, Eigen::Index n)
+{
+#ifdef _OPENMP
+    const Eigen::Index threads = omp_get_max_threads();
+#else
+    const Eigen::Index threads = 1;
+#endif
+    return std::max<Eigen::Index>(1, std::min(threads, m / std::max<Eigen::Index>(n, 1)));
+}
+
+/// @brief First row of block k out of p.
+inline Eigen::Index blockStart(Eigen::Index m, Eigen::Index p, Eigen::Index k)
+{
+    return k * m / p;
+}
+
+/// @brief Gram matrix A^T A. Every thread accumulates the symmetric rank update of its row block, and the n x n
+/// partial sums are added at the end, so the reduction runs in parallel however small n is.
+inline Eigen::MatrixXd gram(const Eigen::MatrixXd& A)
+{
+    const Eigen::Index           m = A.rows();
+    const Eigen::Index           n = A.cols();
+    const Eigen::Index           p = rowBlocks(m, n);
+    std::vector<Eigen::MatrixXd> partial(p, Eigen::MatrixXd::Zero(n, n));
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = blockStart(m, p, k);
+        const Eigen::Index r1 = blockStart(m, p, k + 1);
+        partial[k].selfadjointView<Eigen::Lower>().rankUpdate(A.middleRows(r0, r1 - r0).transpose());
+    }
+    for (Eigen::Index k = 1; k < p; k++)
+    {
+        partial[0] += partial[k];
+    }
+    return partial[0].selfadjointView<Eigen::Lower>();
+}
+
+/// @brief Q = Q R^{-1} in place, by row blocks in parallel.
+inline void rightSolveUpper(Eigen::MatrixXd& Q, const Eigen::MatrixXd& R)
+{
+    const Eigen::Index m = Q.rows();
+    const Eigen::Index p = rowBlocks(m, Q.cols());
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0    = blockStart(m, p, k);
+        const Eigen::Index r1    = blockStart(m, p, k + 1);
+        auto               block = Q.middleRows(r0, r1 - r0);
+        R.triangularView<Eigen::Upper>().solveInPlace<Eigen::OnTheRight>(block);
+    }
+}
+
+/// @brief One CholeskyQR pass on Q in place: G = Q^T Q + shift I = R^T R, Q = Q R^{-1}.
+/// @return false if G is not numerically positive definite.
+inline bool choleskyQRPass(Eigen::MatrixXd& Q, Eigen::MatrixXd& R, double shift = 0.0)
+{
+    Eigen::MatrixXd G = gram(Q);
+    G.diagonal().array() += shift;
+    Eigen::LLT<Eigen::MatrixXd> llt(G);
+    if (llt.info() != Eigen::Success)
+    {
+        return false;
+    }
+    R = llt.matrixU();
+    rightSolveUpper(Q, R);
+    return true;
+}
+
+/// @brief Thin Householder QR of a block: Q is (rows, n), R is (n, n).
+inline void householderBlock(const Eigen::Ref<const Eigen::MatrixXd>& A, Eigen::Ref<Eigen::MatrixXd> Q, Eigen::MatrixXd& R)
+{
+    const Eigen::Index                    n = A.cols();
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
+    R = qr.matrixQR().topRows(n).triangularView<Eigen::Upper>();
+    Q.setIdentity();
+    Q.applyOnTheLeft(qr.householderQ());
+}
+
+}  // namespace detail
+
+
+/// @brief CholeskyQR: one pass, R from the Cholesky factor of A^T A. Fast, but the Gram matrix squares the
+/// condition number, so orthogonality degrades as u kappa^2.
+/// @param A is the (m, n) matrix of full rank.
+/// @param Q is the (m, n) orthonormal factor on exit.
+/// @param R is the (n, n) upper triangular factor on exit.
+/// @return false if A^T A is not numerically positive definite, i.e. kappa above ~u^{-1/2}.
+inline bool choleskyQR(const Eigen::MatrixXd& A, Eigen::MatrixXd& Q, Eigen::MatrixXd& R)
+{
+    Q = A;
+    return detail::choleskyQRPass(Q, R);
+}
+
+
+/// @brief CholeskyQR2: a second CholeskyQR pass on the Q of the first, whose condition number is already near 1,
+/// brings orthogonality to O(u). R = R2 R1.
+/// @param A is the (m, n) matrix of full rank.
+/// @param Q is the (m, n) orthonormal factor on exit.
+/// @param R is the (n, n) upper triangular factor on exit.
+/// @return false if the first pass breaks down, i.e. kappa above ~u^{-1/2}.
+inline bool choleskyQR2(const Eigen::MatrixXd& A, Eigen::MatrixXd& Q, Eigen::MatrixXd& R)
+{
+    Eigen::MatrixXd R1;
+    Q = A;
+    if (!detail::choleskyQRPass(Q, R1) || !detail::choleskyQRPass(Q, R))
+    {
+        return false;
+    }
+    R = (R * R1).eval();
+    return true;
+}
+
+
+/// @brief Shifted CholeskyQR3 (Fukaya et al., 2020): the first pass factors A^T A + s I with the shift
+/// s = 11 (m n + n (n + 1)) u |A|_F^2, which keeps the first Cholesky factorization alive for kappa up to ~u^{-1}.
+/// The Q it leaves has a condition number of about kappa sqrt(s) / |A|, which CholeskyQR2 then makes orthonormal
+/// as long as that stays below ~u^{-1/2}. The shift grows with m n, so the second pass is what limits the mode:
+/// measured on (2000, 50) matrices it holds up to kappa ~ 3e13, on (20000, 50) up to somewhere between 1e12 and
+/// 1e13 depending on the matrix. R = R3 R2 R1.
+/// @param A is the (m, n) matrix of full rank.
+/// @param Q is the (m, n) orthonormal factor on exit.
+/// @param R is the (n, n) upper triangular factor on exit.
+/// @return false if a pass breaks down, i.e. kappa above the limit above.
+inline bool shiftedCholeskyQR3(const Eigen::MatrixXd& A, Eigen::MatrixXd& Q, Eigen::MatrixXd& R)
+{
+    const double m     = static_cast<double>(A.rows());
+    const double n     = static_cast<double>(A.cols());
+    const double u     = std::numeric_limits<double>::epsilon() / 2;
+    const double shift = 11.0 * (m * n + n * (n + 1)) * u * A.squaredNorm();
+
+    Eigen::MatrixXd R1, R2;
+    Q = A;
+    if (!detail::choleskyQRPass(Q, R1, shift) || !detail::choleskyQRPass(Q, R2) || !detail::choleskyQRPass(Q, R))
+    {
+        return false;
+    }
+    R = (R * R2 * R1).eval();
+    return true;
+}
+
+
+/// @brief TSQR: Householder QR of every row block in parallel, then the stacked pairs of R factors are factored
+/// again up a binary tree until one R is left. Q is formed top-down: every tree node passes the n x n halves of
+/// its Q, times what it received, to its children, and each leaf multiplies its block Q by the product. The tree
+/// only touches n x n matrices; both passes over the m rows run in parallel. Unconditionally stable.
+/// @param A is the (m, n) matrix, m >= n.
+/// @param Q is the (m, n) orthonormal factor on exit.
+/// @param R is the (n, n) upper triangular factor on exit.
+/// @param blocks is the number of leaves, 0 for one per OpenMP thread.
+/// @return true, for the interface of the other modes.
+inline bool tsqr(const Eigen::MatrixXd& A, Eigen::MatrixXd& Q, Eigen::MatrixXd& R, Eigen::Index blocks = 0)
+{
+    const Eigen::Index m = A.rows();
+    const Eigen::Index n = A.cols();
+    const Eigen::Index p = blocks > 0 ? std::max<Eigen::Index>(1, std::min(blocks, m / n)) : detail::rowBlocks(m, n);
+    Q.resize(m, n);
+
+    // Leaves
+    std::vector<Eigen::MatrixXd> Rs(p);
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = detail::blockStart(m, p, k);
+        const Eigen::Index r1 = detail::blockStart(m, p, k + 1);
+        detail::householderBlock(A.middleRows(r0, r1 - r0), Q.middleRows(r0, r1 - r0), Rs[k]);
+    }
+
+    // Reduction tree: each level merges nodes 2j and 2j + 1 into node j and keeps the (2n, n) Q of the merge;
+    // an odd node out moves up unchanged and leaves its Q empty
+    std::vector<std::vector<Eigen::MatrixXd>> levels;
+    while (Rs.size() > 1)
+    {
+        const size_t                 parents = (Rs.size() + 1) / 2;
+        std::vector<Eigen::MatrixXd> merges(parents);
+        std::vector<Eigen::MatrixXd> next(parents);
+        for (size_t j = 0; j < parents; j++)
+        {
+            if (2 * j + 1 < Rs.size())
+            {
+                Eigen::MatrixXd stacked(2 * n, n);
+                stacked << Rs[2 * j], Rs[2 * j + 1];
+                merges[j].resize(2 * n, n);
+                detail::householderBlock(stacked, merges[j], next[j]);
+            }
+            else
+            {
+                next[j] = std::move(Rs[2 * j]);
+            }
+        }
+        levels.push_back(std::move(merges));
+        Rs = std::move(next);
+    }
+    R = Rs[0];
+
+    // Top-down: C holds, per node of a level, the n x n factor its leaves multiply their Q by
+    std::vector<Eigen::MatrixXd> C(1, Eigen::MatrixXd::Identity(n, n));
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level)
+    {
+        std::vector<Eigen::MatrixXd> below;
+        for (size_t j = 0; j < level->size(); j++)
+        {
+            const Eigen::MatrixXd& merge = (*level)[j];
+            if (merge.size() > 0)
+            {
+                below.push_back(merge.topRows(n) * C[j]);
+                below.push_back(merge.bottomRows(n) * C[j]);
+            }
+            else
+            {
+                below.push_back(C[j]);
+            }
+        }
+        C = std::move(below);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0    = detail::blockStart(m, p, k);
+        const Eigen::Index r1    = detail::blockStart(m, p, k + 1);
+        auto               block = Q.middleRows(r0, r1 - r0);
+        block                    = (block * C[k]).eval();
+    }
+    return true;
+}
+
+
+/// @brief Factors A with the given mode.
+/// @return false if the mode broke down on A.
+inline bool tallSkinnyQR(TallSkinnyQRMode mode, const Eigen::MatrixXd& A, Eigen::MatrixXd& Q, Eigen::MatrixXd& R)
+{
+    switch (mode)
+    {
+        case TallSkinnyQRMode::CholeskyQR: return choleskyQR(A, Q, R);
+        case TallSkinnyQRMode::CholeskyQR2: return choleskyQR2(A, Q, R);
+        case TallSkinnyQRMode::ShiftedCholeskyQR3: return shiftedCholeskyQR3(A, Q, R);
+        case TallSkinnyQRMode::TSQR: return tsqr(A, Q, R);
+    }
+    return false;
+}
+
+
+/// @brief Name of a mode for reports.
+inline const char* modeName(TallSkinnyQRMode mode)
+{
+    switch (mode)
+    {
+        case TallSkinnyQRMode::CholeskyQR: return "CholeskyQR";
+        case TallSkinnyQRMode::CholeskyQR2: return "CholeskyQR2";
+        case TallSkinnyQRMode::ShiftedCholeskyQR3: return "ShiftedCholeskyQR3";
+        case TallSkinnyQRMode::TSQR: return "TSQR";
+    }
+    return "";
+}
+
+
+/// @brief Accuracy of a computed factorization.
+struct QRQuality
+{
+    double orthogonality = 0;  // |Q^T Q - I|_F
+    double residual      = 0;  // |A - Q R|_F / |A|_F
+};
+
+/// @brief Measures the loss of orthogonality and the relative residual of a factorization; both passes over
+/// the m rows use the parallel Gram and block products.
+inline QRQuality qrQuality(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Q, const Eigen::MatrixXd& R)
+{
+    QRQuality q;
+    q.orthogonality = (detail::gram(Q) - Eigen::MatrixXd::Identity(Q.cols(), Q.cols())).norm();
+
+    const Eigen::Index  m = A.rows();
+    const Eigen::Index  p = detail::rowBlocks(m, A.cols());
+    std::vector<double> partial(p);
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index r0 = detail::blockStart(m, p, k);
+        const Eigen::Index r1 = detail::blockStart(m, p, k + 1);
+        partial[k] = (A.middleRows(r0, r1 - r0) - Q.middleRows(r0, r1 - r0) * R).squaredNorm();
+    }
+    double sum = 0;
+    for (double s : partial)
+    {
+        sum += s;
+    }
+    q.residual = std::sqrt(sum) / A.norm();
+    return q;
+}
@@ -0,0 +1,604 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+
+
+// Factorizations and solvers for large batches of independent N x N systems, N known at compile time.
+//
+// A batch is stored interleaved, structure-of-arrays: row s of the array is system s and column k holds entry k
+// of every system, entry k = i + N j of a column-major N x N matrix, and entry i of a vector. Entry k of
+// consecutive systems is contiguous, so every step of an algorithm is one loop over the systems that the compiler
+// turns into SIMD instructions, one system per lane, with no shuffles and no gathers. Pivot choices and
+// convergence are per system and become selects instead of branches. The batch is processed in chunks of
+// kSmallBatchChunk systems, one chunk per OpenMP thread at a time, so the entries of a chunk stay in cache
+// between the steps.
+
+
+/// @brief N x N matrices of a batch, one system per row, entry i + N j of system s at (s, i + N j).
+template<typename T, int N>
+using BatchedMatrices = Eigen::Array<T, Eigen::Dynamic, N * N>;
+
+/// @brief Vectors of length N of a batch, one system per row.
+template<typename T, int N>
+using BatchedVectors = Eigen::Array<T, Eigen::Dynamic, N>;
+
+/// @brief Row pivots of a batch of LU factorizations, row k was swapped with row pivots(s, k) >= k.
+template<int N>
+using BatchedPivots = Eigen::Array<int, Eigen::Dynamic, N>;
+
+
+/// Number of systems per chunk: a chunk of 8 x 8 double matrices is 64 KB and of 3 x 3 ones 9 KB.
+inline constexpr Eigen::Index kSmallBatchChunk = 128;
+
+
+/// @brief Matrix of system s of a batch.
+template<int N, typename T>
+Eigen::Matrix<T, N, N> batchedMatrix(const BatchedMatrices<T, N>& A, Eigen::Index s)
+{
+    Eigen::Matrix<T, N, N> M;
+    for (int k = 0; k < N * N; k++)
+    {
+        M.data()[k] = A(s, k);
+    }
+    return M;
+}
+
+/// @brief Sets the matrix of system s of a batch.
+template<int N, typename T>
+void setBatchedMatrix(BatchedMatrices<T, N>& A, Eigen::Index s, const Eigen::Matrix<T, N, N>& M)
+{
+    for (int k = 0; k < N * N; k++)
+    {
+        A(s, k) = M.data()[k];
+    }
+}
+
+
+namespace detail
+{
+
+/// @brief y -= a * x over the w systems of a chunk.
+template<typename T>
+inline void subtractProduct(T* y, const T* a, const T* x, Eigen::Index w)
+{
+    #pragma omp simd
+    for (Eigen::Index l = 0; l < w; l++)
+    {
+        y[l] -= a[l] * x[l];
+    }
+}
+
+/// @brief y /= d over the w systems of a chunk.
+template<typename T>
+inline void divide(T* y, const T* d, Eigen::Index w)
+{
+    #pragma omp simd
+    for (Eigen::Index l = 0; l < w; l++)
+    {
+        y[l] /= d[l];
+    }
+}
+
+/// @brief Forward substitution L y = b for the systems of a chunk, L the lower triangle of the batch at pa.
+template<int N, bool UnitDiagonal, typename T>
+void lowerSolve(const T* pa, T* pb, Eigen::Index batch, Eigen::Index r, Eigen::Index w)
+{
+    for (int i = 0; i < N; i++)
+    {
+        T* bi = pb + i * batch + r;
+        for (int k = 0; k < i; k++)
+        {
+            subtractProduct(bi, pa + (i + N * k) * batch + r, pb + k * batch + r, w);
+        }
+        if constexpr (!UnitDiagonal)
+        {
+            divide(bi, pa + (i + N * i) * batch + r, w);
+        }
+    }
+}
+
+/// @brief Back substitution U x = y for the systems of a chunk, U the upper triangle of the batch at pa, or the
+/// transpose of its lower triangle.
+template<int N, bool TransposedLower, typename T>
+void upperSolve(const T* pa, T* pb, Eigen::Index batch, Eigen::Index r, Eigen::Index w)
+{
+    for (int i = N - 1; i >= 0; i--)
+    {
+        T* bi = pb + i * batch + r;
+        for (int k = i + 1; k < N; k++)
+        {
+            const int entry = TransposedLower ? k + N * i : i + N * k;
+            subtractProduct(bi, pa + entry * batch + r, pb + k * batch + r, w);
+        }
+        divide(bi, pa + (i + N * i) * batch + r, w);
+    }
+}
+
+/// @brief Number of systems of a chunk with a zero or NaN diagonal entry after a factorization. A breakdown turns
+/// the later pivots of the system into NaN, so the systems are counted rather than the pivots.
+template<int N, typename T>
+Eigen::Index countBadPivots(const T* pa, Eigen::Index batch, Eigen::Index r, Eigen::Index w)
+{
+    alignas(64) T smallest[kSmallBatchChunk];
+    std::fill(smallest, smallest + w, T(1));
+    for (int k = 0; k < N; k++)
+    {
+        const T* akk = pa + k * (N + 1) * batch + r;
+        #pragma omp simd
+        for (Eigen::Index l = 0; l < w; l++)
+        {
+            // NaN fails the comparison and ends up as zero
+            smallest[l] = std::abs(akk[l]) > T(0) ? smallest[l] : T(0);
+        }
+    }
+    Eigen::Index bad = 0;
+    #pragma omp simd reduction(+ : bad)
+    for (Eigen::Index l = 0; l < w; l++)
+    {
+        bad += smallest[l] == T(0);
+    }
+    return bad;
+}
+
+}  // namespace detail
+
+
+/// @brief Cholesky factorization A = L L^T of every system in place, left-looking by columns. The lower triangle
+/// is overwritten by L, the strict upper triangle is left as is.
+/// @param A is the batch of symmetric positive definite matrices.
+/// @return The number of systems with a non-positive pivot, whose factors are not usable.
+template<int N, typename T>
+Eigen::Index batchedCholeskyFactor(BatchedMatrices<T, N>& A)
+{
+    const Eigen::Index batch    = A.rows();
+    T*                 pa       = A.data();
+    Eigen::Index       failures = 0;
+    auto               at       = [=](int i, int j, Eigen::Index r) { return pa + (i + N * j) * batch + r; };
+
+    #pragma omp parallel for schedule(static) reduction(+ : failures)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        for (int j = 0; j < N; j++)
+        {
+            for (int k = 0; k < j; k++)
+            {
+                for (int i = j; i < N; i++)
+                {
+                    detail::subtractProduct(at(i, j, r), at(i, k, r), at(j, k, r), w);
+                }
+            }
+
+            // A negative pivot becomes NaN and is counted at the end; Eigen's sqrt vectorizes without -fno-math-errno
+            T*                                         ajj = at(j, j, r);
+            Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> d(ajj, w);
+            d = d.sqrt();
+            for (int i = j + 1; i < N; i++)
+            {
+                detail::divide(at(i, j, r), ajj, w);
+            }
+        }
+        failures += detail::countBadPivots<N>(pa, batch, r, w);
+    }
+    return failures;
+}
+
+
+/// @brief Solves L L^T x = b for every system in place.
+/// @param L is the batch of factors from batchedCholeskyFactor.
+/// @param B is the batch of right-hand sides, overwritten by the solutions.
+template<int N, typename T>
+void batchedCholeskySolve(const BatchedMatrices<T, N>& L, BatchedVectors<T, N>& B)
+{
+    const Eigen::Index batch = L.rows();
+    assert(B.rows() == batch);
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        detail::lowerSolve<N, false>(L.data(), B.data(), batch, r, w);
+        detail::upperSolve<N, true>(L.data(), B.data(), batch, r, w);
+    }
+}
+
+
+/// @brief LU factorization P A = L U with partial pivoting of every system in place. Every system picks its own
+/// pivot; the search and the row swaps are selects, so all lanes run the same instructions.
+/// @param A is the batch of matrices, overwritten by U and the unit lower L below the diagonal.
+/// @param pivots receives the row swaps.
+/// @return The number of systems with a zero pivot, i.e. singular matrices.
+template<int N, typename T>
+Eigen::Index batchedLUFactor(BatchedMatrices<T, N>& A, BatchedPivots<N>& pivots)
+{
+    const Eigen::Index batch = A.rows();
+    pivots.resize(batch, N);
+    T*           pa       = A.data();
+    int*         pp       = pivots.data();
+    Eigen::Index failures = 0;
+    auto         at       = [=](int i, int j, Eigen::Index r) { return pa + (i + N * j) * batch + r; };
+
+    #pragma omp parallel for schedule(static) reduction(+ : failures)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        // Pivot row and its magnitude per system, the row kept as T so the selects stay in one vector type
+        alignas(64) T pivot[kSmallBatchChunk];
+        alignas(64) T best[kSmallBatchChunk];
+
+        for (int k = 0; k < N; k++)
+        {
+            // Largest entry of column k on or below the diagonal
+            const T* akk = at(k, k, r);
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                best[l]  = std::abs(akk[l]);
+                pivot[l] = T(k);
+            }
+            for (int i = k + 1; i < N; i++)
+            {
+                const T* aik = at(i, k, r);
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    // A 0/1 blend rather than two selects, which gcc does not if-convert at -O2
+                    const T v      = std::abs(aik[l]);
+                    const T larger = v > best[l] ? T(1) : T(0);
+                    pivot[l]      += larger * (T(i) - pivot[l]);
+                    best[l]        = std::max(v, best[l]);
+                }
+            }
+            int* pk = pp + k * batch + r;
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                pk[l] = static_cast<int>(pivot[l]);
+            }
+
+            // Swap the whole rows, as LAPACK does, so L and U end up in the permuted order
+            for (int i = k + 1; i < N; i++)
+            {
+                for (int j = 0; j < N; j++)
+                {
+                    T* akj = at(k, j, r);
+                    T* aij = at(i, j, r);
+                    #pragma omp simd
+                    for (Eigen::Index l = 0; l < w; l++)
+                    {
+                        const T a = akj[l];
+                        const T b = aij[l];
+                        akj[l]    = pivot[l] == T(i) ? b : a;
+                        aij[l]    = pivot[l] == T(i) ? a : b;
+                    }
+                }
+            }
+
+            // Multipliers and the rank-1 update of the trailing block
+            for (int i = k + 1; i < N; i++)
+            {
+                detail::divide(at(i, k, r), akk, w);
+            }
+            for (int j = k + 1; j < N; j++)
+            {
+                for (int i = k + 1; i < N; i++)
+                {
+                    detail::subtractProduct(at(i, j, r), at(i, k, r), at(k, j, r), w);
+                }
+            }
+        }
+        failures += detail::countBadPivots<N>(pa, batch, r, w);
+    }
+    return failures;
+}
+
+
+/// @brief Solves A x = b for every system in place, with P A = L U from batchedLUFactor.
+/// @param LU is the batch of factors.
+/// @param pivots is the batch of row swaps.
+/// @param B is the batch of right-hand sides, overwritten by the solutions.
+template<int N, typename T>
+void batchedLUSolve(const BatchedMatrices<T, N>& LU, const BatchedPivots<N>& pivots, BatchedVectors<T, N>& B)
+{
+    const Eigen::Index batch = LU.rows();
+    assert(B.rows() == batch && pivots.rows() == batch);
+    const int* pp = pivots.data();
+    T*         pb = B.data();
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        // P b, then L y = P b, then U x = y
+        for (int k = 0; k < N - 1; k++)
+        {
+            const int* pk = pp + k * batch + r;
+            T*         bk = pb + k * batch + r;
+            for (int i = k + 1; i < N; i++)
+            {
+                T* bi = pb + i * batch + r;
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    const T a = bk[l];
+                    const T b = bi[l];
+                    bk[l]     = pk[l] == i ? b : a;
+                    bi[l]     = pk[l] == i ? a : b;
+                }
+            }
+        }
+        detail::lowerSolve<N, true>(LU.data(), pb, batch, r, w);
+        detail::upperSolve<N, false>(LU.data(), pb, batch, r, w);
+    }
+}
+
+
+/// @brief Householder QR factorization A = Q R of every system in place, as LAPACK's geqr2: the reflector
+/// H_k = I - tau_k v_k v_k^T zeroes column k below the diagonal, v_k = [1; essential part].
+/// @param A is the batch of matrices, overwritten by R and the essential parts of the reflectors below it.
+/// @param tau receives the reflector coefficients.
+template<int N, typename T>
+void batchedQRFactor(BatchedMatrices<T, N>& A, BatchedVectors<T, N>& tau)
+{
+    const Eigen::Index batch = A.rows();
+    tau.resize(batch, N);
+    T*   pa = A.data();
+    T*   pt = tau.data();
+    auto at = [=](int i, int j, Eigen::Index r) { return pa + (i + N * j) * batch + r; };
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        alignas(64) T sum[kSmallBatchChunk];
+
+        for (int k = 0; k < N; k++)
+        {
+            // Reflector of column k; a column that is already zero below the diagonal gets tau = 0
+            std::fill(sum, sum + w, T(0));
+            for (int i = k + 1; i < N; i++)
+            {
+                const T* aik = at(i, k, r);
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    sum[l] += aik[l] * aik[l];
+                }
+            }
+            T* tk  = pt + k * batch + r;
+            T* akk = at(k, k, r);
+            alignas(64) T norm[kSmallBatchChunk];
+            Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>(norm, w) =
+                (Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(akk, w).square() +
+                 Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>(sum, w))
+                    .sqrt();
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                const T    alpha = akk[l];
+                const bool skip  = sum[l] == T(0);
+                const T    beta  = skip ? alpha : (alpha >= T(0) ? -norm[l] : norm[l]);
+                tk[l]            = skip ? T(0) : (beta - alpha) / beta;
+                sum[l]           = skip ? T(0) : T(1) / (alpha - beta);  // scale of the essential part
+                akk[l]           = beta;
+            }
+            for (int i = k + 1; i < N; i++)
+            {
+                T* aik = at(i, k, r);
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    aik[l] *= sum[l];
+                }
+            }
+
+            // H_k applied to the columns on the right: a_j -= tau_k (v_k^T a_j) v_k
+            for (int j = k + 1; j < N; j++)
+            {
+                T* akj = at(k, j, r);
+                std::copy(akj, akj + w, sum);
+                for (int i = k + 1; i < N; i++)
+                {
+                    const T* aik = at(i, k, r);
+                    const T* aij = at(i, j, r);
+                    #pragma omp simd
+                    for (Eigen::Index l = 0; l < w; l++)
+                    {
+                        sum[l] += aik[l] * aij[l];
+                    }
+                }
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    sum[l] *= tk[l];
+                    akj[l] -= sum[l];
+                }
+                for (int i = k + 1; i < N; i++)
+                {
+                    detail::subtractProduct(at(i, j, r), sum, at(i, k, r), w);
+                }
+            }
+        }
+    }
+}
+
+
+/// @brief Solves A x = b for every system in place, with A = Q R from batchedQRFactor: x = R^{-1} Q^T b.
+/// @param QR is the batch of factors.
+/// @param tau is the batch of reflector coefficients.
+/// @param B is the batch of right-hand sides, overwritten by the solutions.
+template<int N, typename T>
+void batchedQRSolve(const BatchedMatrices<T, N>& QR, const BatchedVectors<T, N>& tau, BatchedVectors<T, N>& B)
+{
+    const Eigen::Index batch = QR.rows();
+    assert(B.rows() == batch && tau.rows() == batch);
+    const T* pa = QR.data();
+    const T* pt = tau.data();
+    T*       pb = B.data();
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index r = 0; r < batch; r += kSmallBatchChunk)
+    {
+        const Eigen::Index w = std::min(kSmallBatchChunk, batch - r);
+        alignas(64) T sum[kSmallBatchChunk];
+
+        // Q^T b = H_{N-1} ... H_0 b
+        for (int k = 0; k < N; k++)
+        {
+            const T* tk = pt + k * batch + r;
+            T*       bk = pb + k * batch + r;
+            std::copy(bk, bk + w, sum);
+            for (int i = k + 1; i < N; i++)
+            {
+                const T* vi = pa + (i + N * k) * batch + r;
+                const T* bi = pb + i * batch + r;
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    sum[l] += vi[l] * bi[l];
+                }
+            }
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                sum[l] *= tk[l];
+                bk[l]  -= sum[l];
+            }
+            for (int i = k + 1; i < N; i++)
+            {
+                detail::subtractProduct(pb + i * batch + r, sum, pa + (i + N * k) * batch + r, w);
+            }
+        }
+        detail::upperSolve<N, false>(pa, pb, batch, r, w);
+    }
+}
+
+
+/// @brief Conjugate gradient for every system, all systems in lock step. A system that has converged keeps
+/// iterating with a zero step, so the lanes never diverge; in exact arithmetic N iterations solve every system.
+/// @param A is the batch of symmetric positive definite matrices.
+/// @param B is the batch of right-hand sides.
+/// @param X is the batch of initial guesses, overwritten by the solutions.
+/// @param maxIterations is the number of iterations.
+/// @param tolerance is the relative residual |b - A x| / |b| at which a system stops.
+/// @return The number of systems that did not reach the tolerance.
+template<int N, typename T>
+Eigen::Index batchedConjugateGradient(const BatchedMatrices<T, N>& A, const BatchedVectors<T, N>& B,
+                                      BatchedVectors<T, N>& X, int maxIterations = N,
+                                      T tolerance = std::sqrt(Eigen::NumTraits<T>::epsilon()))
+{
+    const Eigen::Index batch = A.rows();
+    assert(B.rows() == batch && X.rows() == batch);
+    const T*           pa         = A.data();
+    const T*           pb         = B.data();
+    T*                 px         = X.data();
+    const T            tol2       = tolerance * tolerance;
+    Eigen::Index       unfinished = 0;
+    constexpr auto     chunk      = kSmallBatchChunk;
+
+    #pragma omp parallel for schedule(static) reduction(+ : unfinished)
+    for (Eigen::Index r = 0; r < batch; r += chunk)
+    {
+        const Eigen::Index w = std::min(chunk, batch - r);
+        // Residual, direction and A p of the chunk, entry i at i * chunk, and the per-system scalars
+        alignas(64) T rv[N * chunk], pv[N * chunk], wv[N * chunk];
+        alignas(64) T rr[chunk], bb[chunk], pAp[chunk], rrNew[chunk];
+        auto          sumOfProducts = [w](T* out, const T* u, const T* v) {
+            std::fill(out, out + w, T(0));
+            for (int i = 0; i < N; i++)
+            {
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    out[l] += u[i * chunk + l] * v[i * chunk + l];
+                }
+            }
+        };
+
+        // r = b - A x, p = r
+        for (int i = 0; i < N; i++)
+        {
+            std::copy(pb + i * batch + r, pb + i * batch + r + w, rv + i * chunk);
+            for (int k = 0; k < N; k++)
+            {
+                detail::subtractProduct(rv + i * chunk, pa + (i + N * k) * batch + r, px + k * batch + r, w);
+            }
+            std::copy(rv + i * chunk, rv + i * chunk + w, pv + i * chunk);
+            std::copy(pb + i * batch + r, pb + i * batch + r + w, wv + i * chunk);
+        }
+        sumOfProducts(rr, rv, rv);
+        sumOfProducts(bb, wv, wv);
+
+        for (int it = 0; it < maxIterations; it++)
+        {
+            // w = A p, column by column
+            std::fill(wv, wv + N * chunk, T(0));
+            for (int k = 0; k < N; k++)
+            {
+                for (int i = 0; i < N; i++)
+                {
+                    const T* aik = pa + (i + N * k) * batch + r;
+                    const T* pk  = pv + k * chunk;
+                    T*       wi  = wv + i * chunk;
+                    #pragma omp simd
+                    for (Eigen::Index l = 0; l < w; l++)
+                    {
+                        wi[l] += aik[l] * pk[l];
+                    }
+                }
+            }
+
+            // Step length, zero for the systems that have converged
+            sumOfProducts(pAp, pv, wv);
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                pAp[l] = rr[l] > tol2 * bb[l] ? rr[l] / pAp[l] : T(0);
+            }
+            for (int i = 0; i < N; i++)
+            {
+                T*       xi = px + i * batch + r;
+                T*       ri = rv + i * chunk;
+                const T* pi = pv + i * chunk;
+                const T* wi = wv + i * chunk;
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    xi[l] += pAp[l] * pi[l];
+                    ri[l] -= pAp[l] * wi[l];
+                }
+            }
+
+            // New direction, p = r + (r_new^T r_new / r^T r) p
+            sumOfProducts(rrNew, rv, rv);
+            #pragma omp simd
+            for (Eigen::Index l = 0; l < w; l++)
+            {
+                const bool active = pAp[l] != T(0);
+                pAp[l]            = active ? rrNew[l] / rr[l] : T(0);
+                rr[l]             = active ? rrNew[l] : rr[l];
+            }
+            for (int i = 0; i < N; i++)
+            {
+                T*       pi = pv + i * chunk;
+                const T* ri = rv + i * chunk;
+                #pragma omp simd
+                for (Eigen::Index l = 0; l < w; l++)
+                {
+                    pi[l] = ri[l] + pAp[l] * pi[l];
+                }
+            }
+        }
+
+        #pragma omp simd reduction(+ : unfinished)
+        for (Eigen::Index l = 0; l < w; l++)
+        {
+            unfinished += rr[l] > tol2 * bb[l];
+        }
+    }
+    return unfinished;
+}
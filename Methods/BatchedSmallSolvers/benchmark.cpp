@@ -0,0 +1,142 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "batched_small_solvers.hpp"
+#include "benchmark_stats.hpp"
+
+using Eigen::Index;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Prints a line of the table: throughput of the batched solver and of the loop over Eigen's fixed-size
+/// solver, and the speedup.
+void report(const std::string& name, Index batch, double batched, double eigen)
+{
+    cout << setw(12) << name << setw(18) << batch / batched / 1e6 << setw(18) << batch / eigen / 1e6 << setw(12)
+         << eigen / batched << endl;
+}
+
+
+/// @brief Conjugate gradient on one fixed-size system, the per-system counterpart of batchedConjugateGradient.
+template<int N, typename T>
+Eigen::Matrix<T, N, 1> fixedSizeConjugateGradient(const Eigen::Matrix<T, N, N>& A, const Eigen::Matrix<T, N, 1>& b,
+                                                  T tolerance)
+{
+    Eigen::Matrix<T, N, 1> x = Eigen::Matrix<T, N, 1>::Zero();
+    Eigen::Matrix<T, N, 1> r = b;
+    Eigen::Matrix<T, N, 1> p = r;
+    T                      rr = r.squaredNorm();
+    const T                bb = rr;
+    for (int it = 0; it < N && rr > tolerance * tolerance * bb; it++)
+    {
+        const Eigen::Matrix<T, N, 1> w     = A * p;
+        const T                      alpha = rr / p.dot(w);
+        x += alpha * p;
+        r -= alpha * w;
+        const T rrNew = r.squaredNorm();
+        p             = r + (rrNew / rr) * p;
+        rr            = rrNew;
+    }
+    return x;
+}
+
+
+/// @brief Factor-and-solve throughput for one N and scalar type: the interleaved batch against a loop over
+/// std::vector of Eigen fixed-size matrices, both over all OpenMP threads.
+template<int N, typename T>
+void benchmark(Index batch)
+{
+    using Matrix = Eigen::Matrix<T, N, N>;
+    using Vector = Eigen::Matrix<T, N, 1>;
+    const T tolerance = std::sqrt(Eigen::NumTraits<T>::epsilon());
+
+    BatchedMatrices<T, N> spd(batch, N * N), general(batch, N * N);
+    BatchedVectors<T, N>  B = BatchedVectors<T, N>::Random(batch, N);
+    std::vector<Matrix>   spdAoS(batch), generalAoS(batch);
+    std::vector<Vector>   b(batch), x(batch);
+    for (Index s = 0; s < batch; s++)
+    {
+        const Matrix M = Matrix::Random();
+        spdAoS[s]      = M * M.transpose() + T(N) * Matrix::Identity();
+        generalAoS[s]  = Matrix::Random() + T(N) * Matrix::Identity();
+        b[s]           = B.row(s).transpose();
+        setBatchedMatrix<N>(spd, s, spdAoS[s]);
+        setBatchedMatrix<N>(general, s, generalAoS[s]);
+    }
+
+    cout << endl << batch << " systems, N = " << N << (sizeof(T) == 4 ? ", float" : ", double") << endl;
+    cout << setw(12) << "method" << setw(18) << "batched [M/s]" << setw(18) << "Eigen loop [M/s]" << setw(12) << "speedup"
+         << endl;
+
+    // The factorizations overwrite their input, so every run starts from a fresh copy made in the untimed setup
+    BatchedMatrices<T, N> F;
+    BatchedVectors<T, N>  X, tau;
+    BatchedPivots<N>      pivots;
+    auto                  restore = [&](const BatchedMatrices<T, N>& A) {
+        return [&] {
+            F = A;
+            X = B;
+        };
+    };
+    auto eigenLoop = [&](auto&& solve) {
+        return [&, solve] {
+            #pragma omp parallel for schedule(static)
+            for (Index s = 0; s < batch; s++)
+            {
+                x[s] = solve(s);
+            }
+        };
+    };
+
+    // Every row reports the fastest of the timed runs
+    const BenchmarkOptions opts;
+    report("Cholesky", batch,
+           measure([&] { batchedCholeskyFactor<N>(F); batchedCholeskySolve<N>(F, X); }, opts, restore(spd)).min,
+           measure(eigenLoop([&](Index s) { return Vector(spdAoS[s].llt().solve(b[s])); }), opts).min);
+    report("LU", batch,
+           measure([&] { batchedLUFactor<N>(F, pivots); batchedLUSolve<N>(F, pivots, X); }, opts, restore(general)).min,
+           measure(eigenLoop([&](Index s) { return Vector(generalAoS[s].partialPivLu().solve(b[s])); }), opts).min);
+    report("QR", batch,
+           measure([&] { batchedQRFactor<N>(F, tau); batchedQRSolve<N>(F, tau, X); }, opts, restore(general)).min,
+           measure(eigenLoop([&](Index s) { return Vector(generalAoS[s].householderQr().solve(b[s])); }), opts).min);
+    report("CG", batch,
+           measure([&] { batchedConjugateGradient<N>(spd, B, X, N, tolerance); }, opts, [&] { X.setZero(); }).min,
+           measure(eigenLoop([&](Index s) { return fixedSizeConjugateGradient<N>(spdAoS[s], b[s], tolerance); }), opts).min);
+    if constexpr (N <= 4)
+    {
+        // Eigen's closed-form inverse, the usual shortcut for tiny systems, against the batched LU
+        report("inverse", batch,
+               measure([&] { batchedLUFactor<N>(F, pivots); batchedLUSolve<N>(F, pivots, X); }, opts, restore(general)).min,
+               measure(eigenLoop([&](Index s) { return Vector(generalAoS[s].inverse() * b[s]); }), opts).min);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    // Up to 2^24 matrix entries per batch, so every N fits next to its copies in a few hundred MB
+    const Index batch = argc > 1 ? std::atol(argv[1]) : 1 << 20;
+    auto        sized = [&](int n) { return std::min<Index>(batch, (1 << 24) / (n * n)); };
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl;
+#endif
+    cout << "Throughput in million systems per second, factorization and solve" << endl;
+
+    benchmark<2, double>(sized(2));
+    benchmark<3, double>(sized(3));
+    benchmark<4, double>(sized(4));
+    benchmark<8, double>(sized(8));
+    benchmark<3, float>(sized(3));
+    benchmark<8, float>(sized(8));
+
+    return 0;
+}
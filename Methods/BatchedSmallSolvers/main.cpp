@@ -0,0 +1,100 @@
+#include <cassert>
+#include <iostream>
+#include <Eigen/Dense>
+
+#include "batched_small_solvers.hpp"
+
+using Eigen::Index;
+using std::cout;
+using std::endl;
+
+
+/// @brief Largest normwise backward error |b - A x| / (|A| |x| + |b|) of the batched solutions, O(u) for a stable
+/// solver whatever the condition number.
+template<int N, typename T>
+T maxBackwardError(const BatchedMatrices<T, N>& A, const BatchedVectors<T, N>& X, const BatchedVectors<T, N>& B)
+{
+    T worst = 0;
+    for (Index s = 0; s < X.rows(); s++)
+    {
+        const Eigen::Matrix<T, N, N> M = batchedMatrix<N>(A, s);
+        const Eigen::Matrix<T, N, 1> x = X.row(s).transpose();
+        const Eigen::Matrix<T, N, 1> b = B.row(s).transpose();
+        worst = std::max(worst, (b - M * x).norm() / (M.norm() * x.norm() + b.norm()));
+    }
+    return worst;
+}
+
+
+/// @brief Checks every batched solver on random systems of size N.
+/// @param batch is the number of systems, deliberately not a multiple of the chunk size.
+template<int N, typename T>
+void check(Index batch)
+{
+    using Matrix = Eigen::Matrix<T, N, N>;
+
+    // SPD matrices for Cholesky and CG, general ones for LU and QR; some of the general ones need pivoting
+    BatchedMatrices<T, N> spd(batch, N * N), general(batch, N * N);
+    BatchedVectors<T, N>  B = BatchedVectors<T, N>::Random(batch, N);
+    for (Index s = 0; s < batch; s++)
+    {
+        const Matrix M = Matrix::Random();
+        setBatchedMatrix<N>(spd, s, Matrix(M * M.transpose() + T(N) * Matrix::Identity()));
+        Matrix G = Matrix::Random() + T(N) * Matrix::Identity();
+        if (s % 3 == 0)
+        {
+            G(0, 0) = 0;
+        }
+        setBatchedMatrix<N>(general, s, G);
+    }
+
+    BatchedMatrices<T, N> L = spd;
+    BatchedVectors<T, N>  X = B;
+    [[maybe_unused]] const Index failedLLT = batchedCholeskyFactor<N>(L);
+    assert(failedLLT == 0);
+    batchedCholeskySolve<N>(L, X);
+    const T errLLT = maxBackwardError<N>(spd, X, B);
+
+    BatchedMatrices<T, N> LU = general;
+    BatchedPivots<N>      pivots;
+    X = B;
+    [[maybe_unused]] const Index failedLU = batchedLUFactor<N>(LU, pivots);
+    assert(failedLU == 0);
+    batchedLUSolve<N>(LU, pivots, X);
+    const T errLU = maxBackwardError<N>(general, X, B);
+
+    BatchedMatrices<T, N> QR = general;
+    BatchedVectors<T, N>  tau;
+    X = B;
+    batchedQRFactor<N>(QR, tau);
+    batchedQRSolve<N>(QR, tau, X);
+    const T errQR = maxBackwardError<N>(general, X, B);
+
+    X.setZero();
+    const Index unfinished = batchedConjugateGradient<N>(spd, B, X, 2 * N, T(10) * Eigen::NumTraits<T>::epsilon());
+    const T     errCG      = maxBackwardError<N>(spd, X, B);
+
+    cout << "N = " << N << (sizeof(T) == 4 ? ", float " : ", double") << "  Cholesky " << errLLT << "  LU " << errLU
+         << "  QR " << errQR << "  CG " << errCG << " (" << unfinished << " systems above the CG tolerance)" << endl;
+    [[maybe_unused]] const T tolerance = 10 * N * Eigen::NumTraits<T>::epsilon();
+    assert(errLLT < tolerance && errLU < tolerance && errQR < tolerance && errCG < tolerance);
+
+    // A system that is not positive definite is reported, the others are unaffected
+    L = spd;
+    setBatchedMatrix<N>(L, batch / 2, Matrix(-Matrix::Identity()));
+    [[maybe_unused]] const Index indefinite = batchedCholeskyFactor<N>(L);
+    assert(indefinite == 1);
+}
+
+
+int main()
+{
+    cout << "Largest backward error |b - A x| / (|A| |x| + |b|)" << endl;
+    check<2, double>(1037);
+    check<3, double>(1037);
+    check<4, double>(1037);
+    check<8, double>(1037);
+    check<3, float>(1037);
+    check<8, float>(1037);
+    return 0;
+}
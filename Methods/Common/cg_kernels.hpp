@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <Eigen/Dense>
+
+
+/// @brief Preallocated vectors for the (preconditioned) conjugate gradient iteration. Keeping one
+/// workspace alive across solves of the same size means the iteration itself never allocates.
+/// @tparam T is the scalar type.
+template<typename T>
+struct CGWorkspace
+{
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Vector r;  // residual b - A x
+    Vector z;  // preconditioned residual M^{-1} r (unused by plain CG)
+    Vector p;  // search direction
+    Vector w;  // A p
+
+    CGWorkspace() = default;
+
+    /// @brief Constructor
+    /// @param n is the size of the linear system.
+    explicit CGWorkspace(Eigen::Index n) { resize(n); }
+
+    /// @brief Resizes all vectors, a no-op when the size does not change.
+    /// @param n is the size of the linear system.
+    void resize(Eigen::Index n)
+    {
+        r.resize(n);
+        z.resize(n);
+        p.resize(n);
+        w.resize(n);
+    }
+};
+
+
+/// Number of entries processed per chunk by the fused kernels. The chunk of every operand fits in
+/// L1, so the second and third operation on a chunk hit cache instead of main memory. Chunks are
+/// also the unit of work distributed over OpenMP threads when compiled with -fopenmp.
+constexpr Eigen::Index kFusedChunk = 1024;
+
+
+/// @brief Dot product a.dot(b), computed chunk-wise over OpenMP threads.
+template<typename T>
+T parallelDot(const Eigen::Matrix<T, Eigen::Dynamic, 1>& a, const Eigen::Matrix<T, Eigen::Dynamic, 1>& b)
+{
+    const Eigen::Index n   = a.size();
+    T                  dot = 0;
+#pragma omp parallel for reduction(+ : dot) schedule(static)
+    for (Eigen::Index i = 0; i < n; i += kFusedChunk)
+    {
+        const Eigen::Index len = std::min(kFusedChunk, n - i);
+        dot += a.segment(i, len).dot(b.segment(i, len));
+    }
+    return dot;
+}
+
+
+/// @brief Fused CG update in a single pass over memory: x += alpha * p, r -= alpha * w.
+/// @param x is the current iterate, updated in place.
+/// @param r is the current residual, updated in place.
+/// @param p is the search direction.
+/// @param w is A * p.
+/// @param alpha is the step length.
+/// @return The squared norm r.dot(r) of the updated residual.
+template<typename T>
+T fusedUpdateSolutionResidual(Eigen::Matrix<T, Eigen::Dynamic, 1>&       x,
+                              Eigen::Matrix<T, Eigen::Dynamic, 1>&       r,
+                              const Eigen::Matrix<T, Eigen::Dynamic, 1>& p,
+                              const Eigen::Matrix<T, Eigen::Dynamic, 1>& w,
+                              const T                                    alpha)
+{
+    const Eigen::Index n  = x.size();
+    T                  rr = 0;
+#pragma omp parallel for reduction(+ : rr) schedule(static)
+    for (Eigen::Index i = 0; i < n; i += kFusedChunk)
+    {
+        const Eigen::Index len = std::min(kFusedChunk, n - i);
+        x.segment(i, len) += alpha * p.segment(i, len);
+        r.segment(i, len) -= alpha * w.segment(i, len);
+        rr += r.segment(i, len).squaredNorm();
+    }
+    return rr;
+}
+
+
+/// @brief Direction update p = z + beta * p, evaluated in place without temporaries.
+/// @param p is the search direction, updated in place.
+/// @param z is the (preconditioned) residual.
+/// @param beta is the conjugation coefficient.
+template<typename T>
+void updateDirection(Eigen::Matrix<T, Eigen::Dynamic, 1>& p, const Eigen::Matrix<T, Eigen::Dynamic, 1>& z, const T beta)
+{
+    const Eigen::Index n = p.size();
+#pragma omp parallel for schedule(static)
+    for (Eigen::Index i = 0; i < n; i += kFusedChunk)
+    {
+        const Eigen::Index len = std::min(kFusedChunk, n - i);
+        p.segment(i, len)      = z.segment(i, len) + beta * p.segment(i, len);
+    }
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+
+/// @brief A linear operator is anything that can compute out = A * in without exposing its storage.
+/// The solvers only need rows(), cols() and apply(in, out), so a matrix-free stencil and an explicit
+/// sparse matrix can be used interchangeably.
+template<typename Op>
+concept LinearOperator = requires(const Op&                                                  A,
+                                  const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& in,
+                                  Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>&       out) {
+    { A.rows() } -> std::convertible_to<Eigen::Index>;
+    { A.cols() } -> std::convertible_to<Eigen::Index>;
+    A.apply(in, out);
+};
+
+
+/// Block of k vectors stored as an (n, k) row-major matrix, so the k entries belonging to one
+/// unknown are contiguous and a sparse row is streamed once for all k vectors (SpMM).
+template<typename T>
+using BlockVectors = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+template<typename T>
+using BlockVectorsRef = Eigen::Ref<BlockVectors<T>, 0, Eigen::OuterStride<>>;
+template<typename T>
+using ConstBlockVectorsRef = Eigen::Ref<const BlockVectors<T>, 0, Eigen::OuterStride<>>;
+
+
+/// @brief A block linear operator can additionally compute out = A * in for k vectors at once.
+template<typename Op>
+concept BlockLinearOperator = LinearOperator<Op>
+                              && requires(const Op&                                      A,
+                                          const ConstBlockVectorsRef<typename Op::Scalar>& in,
+                                          BlockVectorsRef<typename Op::Scalar>             out) {
+                                     A.applyBlock(in, out);
+                                 };
+
+
+/// @brief Non-owning wrapper to use a dense Eigen matrix as a LinearOperator. O(n^2) per apply.
+/// @tparam T is the scalar type of the matrix.
+template<typename T>
+struct DenseOperator
+{
+    using Scalar = T;
+    using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    const Matrix& A;
+
+    /// @brief Constructor
+    /// @param A is the dense matrix to wrap, it must outlive the operator.
+    explicit DenseOperator(const Matrix& A)
+    : A(A)
+    {
+    }
+
+    Eigen::Index rows() const { return A.rows(); }
+    Eigen::Index cols() const { return A.cols(); }
+
+    /// @brief Computes out = A * in
+    void apply(const Vector& in, Vector& out) const { out.noalias() = A * in; }
+
+    /// @brief Computes out = A * in for a block of vectors
+    void applyBlock(const ConstBlockVectorsRef<T>& in, BlockVectorsRef<T> out) const { out.noalias() = A * in; }
+};
+
+
+/// @brief Sparse matrix in compressed sparse row (CSR) format. O(nnz) per apply.
+/// @tparam T is the scalar type of the values.
+template<typename T>
+struct CSRMatrix
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Eigen::Index              nRows = 0;
+    Eigen::Index              nCols = 0;
+    std::vector<Eigen::Index> rowPtr;  // size nRows + 1, row i lives in [rowPtr[i], rowPtr[i+1])
+    std::vector<int>          colIdx;  // size nnz
+    std::vector<T>            values;  // size nnz
+
+    CSRMatrix() = default;
+
+    /// @brief Constructor from an Eigen sparse matrix (any storage order), copies the structure.
+    /// @param S is the sparse matrix to convert.
+    template<int Options, typename StorageIndex>
+    explicit CSRMatrix(const Eigen::SparseMatrix<T, Options, StorageIndex>& S)
+    {
+        Eigen::SparseMatrix<T, Eigen::RowMajor, int> R(S);
+        R.makeCompressed();
+        nRows = R.rows();
+        nCols = R.cols();
+        rowPtr.assign(R.outerIndexPtr(), R.outerIndexPtr() + nRows + 1);
+        colIdx.assign(R.innerIndexPtr(), R.innerIndexPtr() + R.nonZeros());
+        values.assign(R.valuePtr(), R.valuePtr() + R.nonZeros());
+    }
+
+    /// @brief Builds a CSR matrix from a triplet list, duplicated entries are summed.
+    /// @param rows is the number of rows.
+    /// @param cols is the number of columns.
+    /// @param triplets is the list of (row, col, value) entries.
+    /// @return The CSR matrix.
+    static CSRMatrix fromTriplets(Eigen::Index rows, Eigen::Index cols, const std::vector<Eigen::Triplet<T>>& triplets)
+    {
+        Eigen::SparseMatrix<T, Eigen::RowMajor, int> R(rows, cols);
+        R.setFromTriplets(triplets.begin(), triplets.end());
+        return CSRMatrix(R);
+    }
+
+    /// @brief Converts the values to another scalar type, the structure is copied as is.
+    /// @return The converted CSR matrix.
+    template<typename U>
+    CSRMatrix<U> cast() const
+    {
+        CSRMatrix<U> C;
+        C.nRows  = nRows;
+        C.nCols  = nCols;
+        C.rowPtr = rowPtr;
+        C.colIdx = colIdx;
+        C.values.assign(values.begin(), values.end());
+        return C;
+    }
+
+    Eigen::Index rows() const { return nRows; }
+    Eigen::Index cols() const { return nCols; }
+    Eigen::Index nonZeros() const { return static_cast<Eigen::Index>(values.size()); }
+
+    /// @brief Bytes read and written by one apply, each input entry counted once.
+    double bytesPerApply() const
+    {
+        return double(values.size()) * (sizeof(T) + sizeof(int)) + double(rowPtr.size()) * sizeof(Eigen::Index)
+             + double(nRows + nCols) * sizeof(T);
+    }
+
+    /// @brief Computes out = A * in
+    void apply(const Vector& in, Vector& out) const
+    {
+        assert(in.size() == nCols && "Input vector has the wrong size");
+        out.resize(nRows);
+        const T*   x   = in.data();
+        const int* col = colIdx.data();
+        const T*   val = values.data();
+#pragma omp parallel for schedule(static)
+        for (Eigen::Index i = 0; i < nRows; i++)
+        {
+            T sum = 0;
+            for (Eigen::Index k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+            {
+                sum += val[k] * x[col[k]];
+            }
+            out[i] = sum;
+        }
+    }
+
+    /// @brief Computes out = A * in for a block of k vectors, streaming A only once.
+    void applyBlock(const ConstBlockVectorsRef<T>& in, BlockVectorsRef<T> out) const
+    {
+        assert(in.rows() == nCols && out.rows() == nRows && in.cols() == out.cols() && "Block sizes do not match");
+#pragma omp parallel for schedule(static)
+        for (Eigen::Index i = 0; i < nRows; i++)
+        {
+            auto o = out.row(i);
+            o.setZero();
+            for (Eigen::Index e = rowPtr[i]; e < rowPtr[i + 1]; e++)
+            {
+                o += values[e] * in.row(colIdx[e]);
+            }
+        }
+    }
+};
+
+
+/// @brief Matrix-free 5-point finite difference Laplacian -Δu on an (nx, ny) interior grid with
+/// homogeneous Dirichlet boundary conditions. The unknown (i, j) is stored at index i + nx * j.
+/// Nothing but the grid size is stored, so the memory footprint is that of the vectors alone.
+/// @tparam T is the scalar type.
+template<typename T>
+struct PoissonStencil2D
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Eigen::Index nx;
+    Eigen::Index ny;
+
+    /// @brief Constructor
+    /// @param nx is the number of interior grid points in x direction.
+    /// @param ny is the number of interior grid points in y direction.
+    PoissonStencil2D(Eigen::Index nx, Eigen::Index ny)
+    : nx(nx)
+    , ny(ny)
+    {
+    }
+
+    Eigen::Index rows() const { return nx * ny; }
+    Eigen::Index cols() const { return nx * ny; }
+
+    /// @brief Computes out = A * in, with A = tridiag(-1, 4, -1) + off-diagonal blocks -I.
+    void apply(const Vector& in, Vector& out) const
+    {
+        assert(in.size() == nx * ny && "Input vector has the wrong size");
+        out.resize(nx * ny);
+        const T* u = in.data();
+        T*       v = out.data();
+#pragma omp parallel for schedule(static)
+        for (Eigen::Index j = 0; j < ny; j++)
+        {
+            const T* uc = u + nx * j;
+            const T* us = (j > 0) ? uc - nx : nullptr;
+            const T* un = (j < ny - 1) ? uc + nx : nullptr;
+            T*       vc = v + nx * j;
+            for (Eigen::Index i = 0; i < nx; i++)
+            {
+                T sum = 4 * uc[i];
+                if (i > 0)
+                    sum -= uc[i - 1];
+                if (i < nx - 1)
+                    sum -= uc[i + 1];
+                if (us)
+                    sum -= us[i];
+                if (un)
+                    sum -= un[i];
+                vc[i] = sum;
+            }
+        }
+    }
+
+    /// @brief Computes out = A * in for a block of k vectors.
+    void applyBlock(const ConstBlockVectorsRef<T>& in, BlockVectorsRef<T> out) const
+    {
+        assert(in.rows() == nx * ny && out.rows() == nx * ny && in.cols() == out.cols() && "Block sizes do not match");
+#pragma omp parallel for schedule(static)
+        for (Eigen::Index j = 0; j < ny; j++)
+        {
+            for (Eigen::Index i = 0; i < nx; i++)
+            {
+                const Eigen::Index idx = i + nx * j;
+                auto               o   = out.row(idx);
+                o                      = 4 * in.row(idx);
+                if (i > 0)
+                    o -= in.row(idx - 1);
+                if (i < nx - 1)
+                    o -= in.row(idx + 1);
+                if (j > 0)
+                    o -= in.row(idx - nx);
+                if (j < ny - 1)
+                    o -= in.row(idx + nx);
+            }
+        }
+    }
+};
+
+
+/// @brief Assembles the same matrix as PoissonStencil2D explicitly in CSR format.
+/// @param nx is the number of interior grid points in x direction.
+/// @param ny is the number of interior grid points in y direction.
+/// @return The (nx * ny, nx * ny) CSR matrix.
+template<typename T>
+CSRMatrix<T> makePoisson2D(Eigen::Index nx, Eigen::Index ny)
+{
+    const Eigen::Index n = nx * ny;
+    CSRMatrix<T>       A;
+    A.nRows = n;
+    A.nCols = n;
+    A.rowPtr.reserve(n + 1);
+    A.colIdx.reserve(5 * n);
+    A.values.reserve(5 * n);
+    A.rowPtr.push_back(0);
+    // Rows are emitted directly in CSR order (columns ascending), no sorting needed
+    for (Eigen::Index j = 0; j < ny; j++)
+    {
+        for (Eigen::Index i = 0; i < nx; i++)
+        {
+            const Eigen::Index k = i + nx * j;
+            auto push = [&](Eigen::Index c, T v) {
+                A.colIdx.push_back(static_cast<int>(c));
+                A.values.push_back(v);
+            };
+            if (j > 0)
+                push(k - nx, -1);
+            if (i > 0)
+                push(k - 1, -1);
+            push(k, 4);
+            if (i < nx - 1)
+                push(k + 1, -1);
+            if (j < ny - 1)
+                push(k + nx, -1);
+            A.rowPtr.push_back(static_cast<Eigen::Index>(A.values.size()));
+        }
+    }
+    return A;
+}
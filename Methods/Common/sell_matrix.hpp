@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <vector>
+#include <Eigen/Dense>
+#include "linear_operators.hpp"
+
+
+/// @brief Sparse matrix in SELL-C-sigma format (Kreutzer et al.). Rows are grouped in chunks of C
+/// consecutive rows, and each chunk is stored column-major and padded to its longest row. Entry j of
+/// the C rows of a chunk are adjacent in memory, so the C rows are processed in lock-step, one row
+/// per SIMD lane. To limit the padding, rows are sorted by length within windows of sigma rows
+/// before chunking; the output is scattered back to the original row order.
+/// @tparam T is the scalar type of the values.
+/// @tparam C is the chunk height, ideally a multiple of the SIMD width for T.
+template<typename T, int C = 8>
+struct SELLMatrix
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Eigen::Index              nRows = 0;
+    Eigen::Index              nCols = 0;
+    Eigen::Index              nnz   = 0;  // without padding
+    Eigen::Index              sigma = 1;
+    std::vector<Eigen::Index> chunkPtr;   // offset of each chunk, size nChunks + 1
+    std::vector<int>          chunkLen;   // padded row length of each chunk
+    std::vector<int>          perm;       // perm[k] is the original row stored at sorted position k
+    std::vector<int>          colIdx;     // padding entries point to column 0 with value 0
+    std::vector<T>            values;
+
+    SELLMatrix() = default;
+
+    /// @brief Constructor from a CSR matrix.
+    /// @param A is the matrix to convert.
+    /// @param window is the sorting window sigma in rows, 1 disables sorting. Rounded up to a multiple of C.
+    explicit SELLMatrix(const CSRMatrix<T>& A, Eigen::Index window = 32 * C)
+    : nRows(A.rows())
+    , nCols(A.cols())
+    , nnz(A.nonZeros())
+    , sigma(std::max<Eigen::Index>(C, (window + C - 1) / C * C))
+    {
+        auto rowLen = [&](int i) { return A.rowPtr[i + 1] - A.rowPtr[i]; };
+
+        perm.resize(nRows);
+        std::iota(perm.begin(), perm.end(), 0);
+        if (window > 1)
+        {
+            for (Eigen::Index start = 0; start < nRows; start += sigma)
+            {
+                const Eigen::Index end = std::min(start + sigma, nRows);
+                std::stable_sort(perm.begin() + start, perm.begin() + end,
+                                 [&](int a, int b) { return rowLen(a) > rowLen(b); });
+            }
+        }
+
+        const Eigen::Index nChunks = (nRows + C - 1) / C;
+        chunkPtr.assign(nChunks + 1, 0);
+        chunkLen.assign(nChunks, 0);
+        for (Eigen::Index c = 0; c < nChunks; c++)
+        {
+            Eigen::Index len = 0;
+            for (Eigen::Index k = c * C; k < std::min((c + 1) * C, nRows); k++)
+            {
+                len = std::max(len, rowLen(perm[k]));
+            }
+            chunkLen[c]     = static_cast<int>(len);
+            chunkPtr[c + 1] = chunkPtr[c] + len * C;
+        }
+
+        colIdx.assign(chunkPtr[nChunks], 0);
+        values.assign(chunkPtr[nChunks], T(0));
+        for (Eigen::Index c = 0; c < nChunks; c++)
+        {
+            for (int lane = 0; lane < C && c * C + lane < nRows; lane++)
+            {
+                const int row = perm[c * C + lane];
+                for (Eigen::Index j = 0; j < rowLen(row); j++)
+                {
+                    colIdx[chunkPtr[c] + j * C + lane] = A.colIdx[A.rowPtr[row] + j];
+                    values[chunkPtr[c] + j * C + lane] = A.values[A.rowPtr[row] + j];
+                }
+            }
+        }
+    }
+
+    Eigen::Index rows() const { return nRows; }
+    Eigen::Index cols() const { return nCols; }
+    Eigen::Index nonZeros() const { return nnz; }
+
+    /// @brief Number of stored entries including padding, over the number of nonzeros.
+    double paddingRatio() const { return nnz ? double(values.size()) / double(nnz) : 1.0; }
+
+    /// @brief Bytes read and written by one apply including padding, each input entry counted once.
+    double bytesPerApply() const
+    {
+        return double(values.size()) * (sizeof(T) + sizeof(int)) + double(chunkPtr.size()) * sizeof(Eigen::Index)
+             + double(chunkLen.size() + perm.size()) * sizeof(int) + double(nRows + nCols) * sizeof(T);
+    }
+
+    /// @brief Computes out = A * in
+    void apply(const Vector& in, Vector& out) const
+    {
+        assert(in.size() == nCols && "Input vector has the wrong size");
+        out.resize(nRows);
+        const T*           x       = in.data();
+        const Eigen::Index nChunks = static_cast<Eigen::Index>(chunkLen.size());
+#pragma omp parallel for schedule(static)
+        for (Eigen::Index c = 0; c < nChunks; c++)
+        {
+            T          sum[C] = {};
+            const T*   val    = values.data() + chunkPtr[c];
+            const int* col    = colIdx.data() + chunkPtr[c];
+            for (int j = 0; j < chunkLen[c]; j++)
+            {
+#pragma omp simd
+                for (int lane = 0; lane < C; lane++)
+                {
+                    sum[lane] += val[j * C + lane] * x[col[j * C + lane]];
+                }
+            }
+            for (int lane = 0; lane < C && c * C + lane < nRows; lane++)
+            {
+                out[perm[c * C + lane]] = sum[lane];
+            }
+        }
+    }
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+
+/// @brief Parts of an iteration the telemetry keeps separate timings for.
+enum class SolverPhase
+{
+    Apply,    // operator apply A * p
+    Vector,   // inner products and vector updates
+    Precond,  // preconditioner apply
+};
+
+
+/// @brief Telemetry hook that records nothing. It is the default of the solvers; every call is an
+/// empty inline function and now() does not read the clock, so the instrumented code compiles to
+/// the same loop as the uninstrumented one.
+struct NoTelemetry
+{
+    static constexpr bool enabled = false;
+
+    int  now() const { return 0; }
+    void begin(Eigen::Index) {}
+    void record(SolverPhase, int, double) {}
+    void endIteration(double) {}
+};
+
+
+/// @brief Telemetry hook that records, per iteration, the residual norm, the time spent in operator
+/// applies, vector operations and preconditioner, and an estimate of the bytes moved. Flags stalled
+/// convergence, and writes the history as CSV or JSON.
+struct SolverTelemetry
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Iteration
+    {
+        int    iteration = 0;
+        double residual  = 0;
+        double tApply    = 0;  // seconds
+        double tVector   = 0;  // seconds
+        double tPrecond  = 0;  // seconds
+        double bytes     = 0;
+        bool   stalled   = false;
+    };
+
+    static constexpr bool enabled = true;
+
+    std::string            solver;
+    Eigen::Index           n = 0;
+    int                    stallWindow;
+    double                 stallFactor;
+    std::vector<Iteration> history;  // entry 0 holds the initial residual
+    Iteration              current;
+
+    /// @brief Constructor
+    /// @param solver is the name written to the JSON output.
+    /// @param stallWindow is the number of iterations over which progress is measured.
+    /// @param stallFactor flags an iteration as stalled when the residual is above stallFactor times the residual stallWindow iterations earlier.
+    explicit SolverTelemetry(std::string solver = "", int stallWindow = 50, double stallFactor = 0.99)
+    : solver(std::move(solver))
+    , stallWindow(stallWindow)
+    , stallFactor(stallFactor)
+    {
+    }
+
+    Clock::time_point now() const { return Clock::now(); }
+
+    /// @brief Starts a new solve, clearing the history.
+    /// @param size is the size of the linear system.
+    void begin(Eigen::Index size)
+    {
+        n = size;
+        history.clear();
+        current = Iteration();
+    }
+
+    /// @brief Adds the time since start and the bytes moved to a phase of the current iteration.
+    void record(SolverPhase phase, Clock::time_point start, double bytes)
+    {
+        const double dt = std::chrono::duration<double>(Clock::now() - start).count();
+        switch (phase)
+        {
+            case SolverPhase::Apply: current.tApply += dt; break;
+            case SolverPhase::Vector: current.tVector += dt; break;
+            case SolverPhase::Precond: current.tPrecond += dt; break;
+        }
+        current.bytes += bytes;
+    }
+
+    /// @brief Closes the current iteration.
+    /// @param residual is the residual norm at the end of the iteration.
+    void endIteration(double residual)
+    {
+        current.iteration = static_cast<int>(history.size());
+        current.residual  = residual;
+        if (current.iteration >= stallWindow)
+        {
+            current.stalled = residual > stallFactor * history[current.iteration - stallWindow].residual;
+        }
+        history.push_back(current);
+        current = Iteration();
+    }
+
+    /// @brief Number of recorded iterations, without the initial residual.
+    int iterations() const { return history.empty() ? 0 : static_cast<int>(history.size()) - 1; }
+
+    /// @brief Whether the last recorded iteration is stalled.
+    bool stalled() const { return !history.empty() && history.back().stalled; }
+
+    /// @brief Sum of all iterations.
+    Iteration totals() const
+    {
+        Iteration t;
+        for (const Iteration& it : history)
+        {
+            t.tApply += it.tApply;
+            t.tVector += it.tVector;
+            t.tPrecond += it.tPrecond;
+            t.bytes += it.bytes;
+        }
+        t.iteration = iterations();
+        t.residual  = history.empty() ? 0 : history.back().residual;
+        t.stalled   = stalled();
+        return t;
+    }
+
+    /// @brief Writes one line per iteration to a CSV file.
+    /// @param path is the output file.
+    void writeCSV(const std::string& path) const
+    {
+        std::ofstream out(path);
+        out << "iteration,residual,t_apply,t_vector,t_precond,bytes,stalled\n";
+        for (const Iteration& it : history)
+        {
+            out << it.iteration << ',' << it.residual << ',' << it.tApply << ',' << it.tVector << ',' << it.tPrecond
+                << ',' << it.bytes << ',' << it.stalled << '\n';
+        }
+    }
+
+    /// @brief Writes the totals and the per-iteration history to a JSON file.
+    /// @param path is the output file.
+    void writeJSON(const std::string& path) const
+    {
+        auto entry = [](std::ofstream& out, const Iteration& it) {
+            out << "{\"iteration\": " << it.iteration << ", \"residual\": " << it.residual
+                << ", \"t_apply\": " << it.tApply << ", \"t_vector\": " << it.tVector
+                << ", \"t_precond\": " << it.tPrecond << ", \"bytes\": " << it.bytes
+                << ", \"stalled\": " << (it.stalled ? "true" : "false") << "}";
+        };
+        std::ofstream out(path);
+        out << "{\n  \"solver\": \"" << solver << "\",\n  \"n\": " << n << ",\n  \"totals\": ";
+        entry(out, totals());
+        out << ",\n  \"history\": [";
+        for (size_t i = 0; i < history.size(); i++)
+        {
+            out << (i ? ",\n    " : "\n    ");
+            entry(out, history[i]);
+        }
+        out << "\n  ]\n}\n";
+    }
+};
+
+
+/// @brief Bytes moved by one apply of an operator. Operators can report it through
+/// bytesPerApply(), otherwise reading the input and writing the output vector is assumed.
+template<typename Op>
+double bytesPerApply(const Op& A)
+{
+    if constexpr (requires { A.bytesPerApply(); })
+    {
+        return static_cast<double>(A.bytesPerApply());
+    }
+    else
+    {
+        return static_cast<double>(A.rows() + A.cols()) * sizeof(typename Op::Scalar);
+    }
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <Eigen/Dense>
+#include "linear_operators.hpp"
+
+
+/// @brief Preallocated storage for blockConjugateGradientInPlace. Each block holds the (n, kActive)
+/// row-major matrix of the systems that have not converged yet, packed with leading dimension
+/// kActive, so every kernel works on one contiguous array.
+/// @tparam T is the scalar type.
+template<typename T>
+struct BlockCGWorkspace
+{
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    using Array  = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+    Vector           X;      // iterates
+    Vector           R;      // residuals
+    Vector           P;      // search directions
+    Vector           W;      // A * P
+    Array            rr;     // squared residual norms
+    Array            rrNew;  // squared residual norms after the update
+    Array            alpha;
+    Array            beta;
+    std::vector<int> perm;   // perm[c] is the original index of the system stored in column c
+
+    /// @brief Resizes all blocks, a no-op when the sizes do not change.
+    /// @param n is the size of the linear systems.
+    /// @param k is the number of right hand sides.
+    void resize(Eigen::Index n, Eigen::Index k)
+    {
+        X.resize(n * k);
+        R.resize(n * k);
+        P.resize(n * k);
+        W.resize(n * k);
+        rr.resize(k);
+        rrNew.resize(k);
+        alpha.resize(k);
+        beta.resize(k);
+        perm.resize(k);
+    }
+};
+
+
+/// @brief Removes column c from an (n, k) row-major matrix packed with leading dimension k, leaving
+/// an (n, k - 1) matrix packed with leading dimension k - 1 in the same storage.
+template<typename T>
+void removePackedColumn(T* data, Eigen::Index n, Eigen::Index k, Eigen::Index c)
+{
+    // The first c entries of row 0 are already in place. Every other destination starts before its source range,
+    // as std::copy requires of overlapping ranges: row i goes to i (k - 1) < i k
+    T* dst = data + c;
+    for (Eigen::Index i = 0; i < n; i++)
+    {
+        const T* src = data + i * k;
+        if (i > 0)
+        {
+            dst = std::copy(src, src + c, dst);
+        }
+        dst = std::copy(src + c + 1, src + k, dst);
+    }
+}
+
+
+/// @brief Computes the solutions of the linear systems A X = B for k right hand sides at once using the conjugate gradient method. The matrix A is expected to be symmetric and positive definite (SPD).
+/// Every system keeps its own CG recurrence, but all of them share one block product A * P per iteration, so A is streamed from memory once instead of k times.
+/// A system is retired as soon as its residual drops below tol, and is no longer included in the products.
+/// @param A is the linear operator of the systems (see BlockLinearOperator).
+/// @param B is the (n, k) matrix of right hand sides.
+/// @param X is the (n, k) matrix of initial guesses on entry and the estimation of the solutions on exit.
+/// @param tol is the error tolerance of the method, applied to each system separately.
+/// @param maxIter is the maximum number of iterations.
+/// @param ws is the workspace, resized if needed.
+/// @return The number of iterations performed for each system.
+template<BlockLinearOperator Op>
+std::vector<int> blockConjugateGradientInPlace(const Op&                                                                 A,
+                                               const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic>& B,
+                                               Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic>&       X,
+                                               const typename Op::Scalar&                                                tol,
+                                               const int&                                                                maxIter,
+                                               BlockCGWorkspace<typename Op::Scalar>&                                    ws)
+{
+    using T = typename Op::Scalar;
+
+    const Eigen::Index n = B.rows();
+    const Eigen::Index k = B.cols();
+    ws.resize(n, k);
+    std::iota(ws.perm.begin(), ws.perm.end(), 0);
+    Eigen::Index kActive = k;
+
+    // (n, kActive) views for the operator, and the same storage seen as (kActive, n) column-major
+    // matrices for the vector kernels, which then reduce and scale along contiguous columns
+    auto block = [&](auto& buf) { return Eigen::Map<BlockVectors<T>>(buf.data(), n, kActive); };
+    auto trans = [&](auto& buf) { return Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>(buf.data(), kActive, n); };
+
+    block(ws.X) = X;
+    A.applyBlock(block(ws.X), block(ws.W));
+    block(ws.R) = B - block(ws.W);
+    ws.P        = ws.R;
+    ws.rr       = trans(ws.R).rowwise().squaredNorm().array();
+
+    std::vector<int> iterations(k, 0);
+    const T          tol2 = tol * tol;
+
+    // Writes the solution in column c back to X and drops the column from the active blocks
+    auto retire = [&](Eigen::Index c) {
+        X.col(ws.perm[c]) = block(ws.X).col(c);
+        for (auto* buf : {&ws.X, &ws.R, &ws.P})
+        {
+            removePackedColumn(buf->data(), n, kActive, c);
+        }
+        for (auto* a : {&ws.rr, &ws.rrNew})
+        {
+            std::copy(a->data() + c + 1, a->data() + kActive, a->data() + c);
+        }
+        ws.perm.erase(ws.perm.begin() + c);
+        kActive--;
+    };
+    auto retireConverged = [&](const auto& norms) {
+        for (Eigen::Index c = kActive - 1; c >= 0; c--)
+        {
+            if (norms[c] < tol2)
+            {
+                retire(c);
+            }
+        }
+    };
+    retireConverged(ws.rr);
+
+    int iter = 0;
+    while (kActive > 0 && iter < maxIter)
+    {
+        A.applyBlock(block(ws.P), block(ws.W));
+        iter++;
+
+        auto Xt    = trans(ws.X);
+        auto Rt    = trans(ws.R);
+        auto Pt    = trans(ws.P);
+        auto Wt    = trans(ws.W);
+        auto alpha = ws.alpha.head(kActive);
+        auto rrNew = ws.rrNew.head(kActive);
+
+        // Column j of the transposed views holds the kActive entries of unknown j, so each kernel
+        // below is a single pass over memory with short contiguous inner updates
+        auto pw = ws.beta.head(kActive);  // beta holds p.dot(w) for now
+        pw.setZero();
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            pw += Pt.col(j).array() * Wt.col(j).array();
+        }
+        alpha = ws.rr.head(kActive) / pw;
+
+        rrNew.setZero();
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            Xt.col(j).array() += alpha * Pt.col(j).array();
+            Rt.col(j).array() -= alpha * Wt.col(j).array();
+            rrNew += Rt.col(j).array().square();
+        }
+
+        for (Eigen::Index c = 0; c < kActive; c++)
+        {
+            iterations[ws.perm[c]] = iter;
+        }
+        retireConverged(ws.rrNew);
+        if (kActive == 0)
+        {
+            break;
+        }
+
+        // Views are rebuilt since retired systems changed the packing
+        auto Pn             = trans(ws.P);
+        auto Rn             = trans(ws.R);
+        auto beta           = ws.beta.head(kActive);
+        beta                = ws.rrNew.head(kActive) / ws.rr.head(kActive);
+        ws.rr.head(kActive) = ws.rrNew.head(kActive);
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            Pn.col(j).array() = Rn.col(j).array() + beta * Pn.col(j).array();
+        }
+    }
+
+    for (Eigen::Index c = 0; c < kActive; c++)
+    {
+        X.col(ws.perm[c]) = block(ws.X).col(c);
+    }
+    return iterations;
+}
+
+
+/// @brief Computes the solutions of the linear systems A X = B for k right hand sides at once using the conjugate gradient method. The matrix A is expected to be symmetric and positive definite (SPD).
+/// @param A is the linear operator of the systems (see BlockLinearOperator).
+/// @param B is the (n, k) matrix of right hand sides.
+/// @param X0 is the (n, k) matrix of initial guesses.
+/// @param tol is the error tolerance of the method, applied to each system separately.
+/// @param maxIter is the maximum number of iterations.
+/// @return Estimation of the (n, k) solution matrix X.
+template<BlockLinearOperator Op>
+Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic> blockConjugateGradient(const Op&                                                                 A,
+                                                                                          const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic>& B,
+                                                                                          const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic>& X0,
+                                                                                          const typename Op::Scalar&                                                tol,
+                                                                                          const int&                                                                maxIter)
+{
+    BlockCGWorkspace<typename Op::Scalar>                              ws;
+    Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, Eigen::Dynamic> X = X0;
+    blockConjugateGradientInPlace(A, B, X, tol, maxIter, ws);
+    return X;
+}
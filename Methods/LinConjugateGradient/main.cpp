@@ -1,48 +1,44 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <iostream>
 #include <Eigen/Dense>
 
+#include "block_conjugate_gradient.hpp"
+#include "conjugate_gradient.hpp"
+#include "pipelined_conjugate_gradient.hpp"
+#include "linear_operators.hpp"
+#include "solver_telemetry.hpp"
+
 using Eigen::MatrixXf;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
 using Eigen::VectorXf;
 using std::cout;
 using std::endl;
 
 
-/// @brief Computes the solution of the linear system Ax = b using the conjugate gradient method. The matrix A is expected to be symmetric and positive definite (SPD).
-/// @param A is the matrix of the linear system.
-/// @param b is the right hand side of the linear system.
-/// @param x0 is the initial guess of the solution.
-/// @param tol is the error tolerance of the method.
-/// @param maxIter is the maximum number of iterations.
-/// @return Estimation of the solution x.
-VectorXf conjugateGradient(MatrixXf& A, VectorXf& b, VectorXf& x0, float& tol, int& maxIter)
+/// @brief Wraps a linear operator and counts its applies.
+template<LinearOperator Op>
+struct CountingOperator
 {
-    VectorXf r = b - A * x0;
-    if (r.norm() < tol)
-    {
-        return x0;
-    }
-    VectorXf p = r;
-    VectorXf x = x0;
-    VectorXf w = A * p;
-    int      k = 0;
-    float    alpha, beta, res;
-    while (k < maxIter)
+    using Scalar = typename Op::Scalar;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+    const Op&   A;
+    mutable int applies = 0;
+
+    Eigen::Index rows() const { return A.rows(); }
+    Eigen::Index cols() const { return A.cols(); }
+
+    /// @brief Computes out = A * in
+    void apply(const Vector& in, Vector& out) const
     {
-        alpha = r.dot(r) / p.dot(w);
-        x     = x + alpha * p;
-        r     = r - alpha * w;
-        res   = r.norm();
-        if (res < tol)
-        {
-            break;
-        }
-        beta = r.dot(r) / p.dot(p);
-        p    = r + beta * p;
-        w    = A * p;
-        k++;
+        applies++;
+        A.apply(in, out);
     }
-    return x;
-}
+};
+
 
 int main()
 {
@@ -58,7 +54,7 @@ int main()
     float tol     = 1e-2;
     int   maxIter = 1000;
 
-    VectorXf x = conjugateGradient(A, b, x0, tol, maxIter);
+    VectorXf x = conjugateGradient(DenseOperator<float>(A), b, x0, tol, maxIter);
     cout << "This is the initial vector x0 : " << endl;
     cout << x0 << endl;
     cout << "This is the found solution vector x : " << endl;
@@ -66,5 +62,86 @@ int main()
     cout << "This is the vector b : " << endl;
     cout << b << endl;
 
+    // Poisson problem -Δu = 1 on a (nx, ny) grid, once as an explicit CSR matrix and once matrix-free
+    const int nx = 128;
+    const int ny = 128;
+    CSRMatrix<float>        Acsr = makePoisson2D<float>(nx, ny);
+    PoissonStencil2D<float> Astencil(nx, ny);
+
+    VectorXf bp       = VectorXf::Ones(nx * ny);
+    VectorXf xp0      = VectorXf::Zero(nx * ny);
+    float    tolp     = 1e-3 * bp.norm();
+    int      maxIterp = 10 * nx;
+
+    VectorXf xcsr     = conjugateGradient(Acsr, bp, xp0, tolp, maxIterp);
+    VectorXf xstencil = conjugateGradient(Astencil, bp, xp0, tolp, maxIterp);
+
+    VectorXf res(nx * ny);
+    Acsr.apply(xcsr, res);
+    cout << "Poisson " << nx << "x" << ny << " (nnz = " << Acsr.nonZeros() << ")" << endl;
+    cout << "CSR     relative residual : " << (bp - res).norm() / bp.norm() << endl;
+    assert((bp - res).norm() < 1e-2 * bp.norm() && "CG on the CSR matrix did not converge");
+    Astencil.apply(xstencil, res);
+    cout << "Stencil relative residual : " << (bp - res).norm() / bp.norm() << endl;
+    assert((bp - res).norm() < 1e-2 * bp.norm() && "CG on the stencil operator did not converge");
+    assert(xcsr.isApprox(xstencil, 1e-2) && "CSR and stencil solutions differ");
+
+    // Same solve with telemetry: residual history, time split and bytes moved, written to CSV and JSON
+    SolverTelemetry telemetry("cg_csr");
+    VectorXf        xtel = conjugateGradient(Acsr, bp, xp0, tolp, maxIterp, telemetry);
+    auto            tot  = telemetry.totals();
+    cout << "Telemetry: " << tot.iteration << " iterations, apply " << tot.tApply << " s, vector ops " << tot.tVector
+         << " s, " << tot.bytes / std::max(tot.tApply + tot.tVector, 1e-12) / 1e9 << " GB/s"
+         << (tot.stalled ? ", stalled" : "") << endl;
+    telemetry.writeCSV("cg_telemetry.csv");
+    telemetry.writeJSON("cg_telemetry.json");
+    assert(xtel == xcsr && "Telemetry changed the iterates");
+    assert(telemetry.history.front().residual > telemetry.history.back().residual && "Telemetry residuals did not decrease");
+
+    // Variants with fewer synchronization points, same call signature
+    VectorXf xpipe  = pipelinedConjugateGradient(Acsr, bp, xp0, tolp, maxIterp);
+    VectorXf xsstep = sStepConjugateGradient(Acsr, bp, xp0, tolp, maxIterp);
+    Acsr.apply(xpipe, res);
+    cout << "Pipelined CG relative residual : " << (bp - res).norm() / bp.norm() << endl;
+    assert((bp - res).norm() < 1e-2 * bp.norm() && "Pipelined CG did not converge");
+    Acsr.apply(xsstep, res);
+    cout << "s-step CG    relative residual : " << (bp - res).norm() / bp.norm() << endl;
+    assert((bp - res).norm() < 1e-2 * bp.norm() && "s-step CG did not converge");
+
+    // A tolerance below what float reaches: the recursive residual gets there but the true one does not, and the
+    // pipelined variant stops after a few failed convergence checks instead of one check, four applies, per iteration
+    CountingOperator<CSRMatrix<float>> Acount{Acsr};
+    VectorXf xtight = pipelinedConjugateGradient(Acount, bp, xp0, 3e-5f * bp.norm(), 100 * maxIterp);
+    Acsr.apply(xtight, res);
+    cout << "Pipelined CG below float accuracy : relative residual " << (bp - res).norm() / bp.norm() << " after "
+         << Acount.applies << " operator applies" << endl;
+    assert(Acount.applies < 2 * maxIterp && "Pipelined CG kept replacing the residual");
+    assert((bp - res).norm() < 2e-4 * bp.norm() && "Pipelined CG stopped before reaching float accuracy");
+
+    // Block CG: k right hand sides share one sparse matrix-matrix product per iteration
+    const int k  = 16;
+    MatrixXf  B  = MatrixXf::Random(nx * ny, k);
+    MatrixXf  X0 = MatrixXf::Zero(nx * ny, k);
+    MatrixXf  Xloop(nx * ny, k);
+
+    auto     start = high_resolution_clock::now();
+    MatrixXf Xblock = blockConjugateGradient(Acsr, B, X0, tolp, maxIterp);
+    double   tBlock = duration<double>(high_resolution_clock::now() - start).count();
+
+    start = high_resolution_clock::now();
+    for (int c = 0; c < k; c++)
+    {
+        Xloop.col(c) = conjugateGradient(Acsr, VectorXf(B.col(c)), xp0, tolp, maxIterp);
+    }
+    double tLoop = duration<double>(high_resolution_clock::now() - start).count();
+
+    cout << "Block CG with " << k << " right hand sides : " << tBlock << " s (one CG per column: " << tLoop << " s)" << endl;
+    for (int c = 0; c < k; c++)
+    {
+        Acsr.apply(Xblock.col(c), res);
+        assert((B.col(c) - res).norm() < 1e-2 * bp.norm() && "Block CG did not converge");
+    }
+    assert(Xblock.isApprox(Xloop, 1e-2) && "Block CG and column-wise CG solutions differ");
+
     return 0;
-}
\ No newline at end of file
+}
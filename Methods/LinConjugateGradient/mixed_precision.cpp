@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <Eigen/Dense>
+
+#include "conjugate_gradient.hpp"
+#include "linear_operators.hpp"
+#include "mixed_precision.hpp"
+
+using Eigen::VectorXd;
+using Eigen::VectorXf;
+using std::cout;
+using std::endl;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+
+/// @brief Prints the outcome of a mixed precision solve.
+/// @param name is the name of the inner operator.
+/// @param rep is the report returned by mixedPrecisionSolve.
+void printReport(const std::string& name, const MixedPrecisionReport& rep)
+{
+    cout << "Mixed precision (" << name << " inner) : rel. residual " << rep.relResidual << ", "
+         << rep.outerIterations << " corrections, " << rep.innerIterations << " inner iterations, "
+         << rep.timeSingle << " s single + " << rep.timeDouble << " s double" << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    // Poisson problem -Δu = f on an (nx, nx) grid
+    const int nx = argc > 1 ? std::stoi(argv[1]) : 256;
+
+    CSRMatrix<double> Ad = makePoisson2D<double>(nx, nx);
+    CSRMatrix<float>  Af = Ad.cast<float>();
+    VectorXd          b  = VectorXd::Random(Ad.rows());
+    VectorXd          r(Ad.rows());
+    const double      tol = 1e-10;
+    const int         maxIter = 100 * nx;
+    cout << "Poisson " << nx << "x" << nx << ", n = " << Ad.rows() << ", target rel. residual " << tol << endl;
+
+    // Single precision CG stagnates far above the target
+    auto     start = high_resolution_clock::now();
+    VectorXf xf    = conjugateGradient(Af, VectorXf(b.cast<float>()), VectorXf(VectorXf::Zero(b.size())), float(tol * b.norm()), maxIter);
+    double   tf    = duration<double>(high_resolution_clock::now() - start).count();
+    Ad.apply(xf.cast<double>(), r);
+    cout << "Single precision CG : rel. residual " << (b - r).norm() / b.norm() << ", " << tf << " s" << endl;
+
+    // Double precision CG reaches it at twice the memory traffic
+    start       = high_resolution_clock::now();
+    VectorXd xd = conjugateGradient(Ad, b, VectorXd(VectorXd::Zero(b.size())), tol * b.norm(), maxIter);
+    double   td = duration<double>(high_resolution_clock::now() - start).count();
+    Ad.apply(xd, r);
+    cout << "Double precision CG : rel. residual " << (b - r).norm() / b.norm() << ", " << td << " s" << endl;
+
+    // Iterative refinement: double precision residuals around single precision CG
+    VectorXd             x   = VectorXd::Zero(b.size());
+    MixedPrecisionReport rep = mixedPrecisionSolve(Ad, Af, b, x, tol, 1e-4f, 50, maxIter);
+    printReport("float", rep);
+    assert(rep.relResidual < tol && "Mixed precision solve with float inner CG did not converge");
+
+    // bf16 keeps 8 bits of mantissa, so the refinement converges only while cond(A) 2^-9 < 1. The Poisson matrix is
+    // too ill-conditioned, and its entries -1 and 4 are exact in bf16 anyway. A backward Euler step I + tau D A D of
+    // the heat equation with a varying diagonal D has cond < 1 + 8 tau 1.3^2 and entries that bf16 has to round.
+    const double      tau = 3.0;
+    CSRMatrix<double> Ht  = Ad;
+    for (Eigen::Index i = 0; i < Ht.rows(); i++)
+    {
+        for (Eigen::Index k = Ht.rowPtr[i]; k < Ht.rowPtr[i + 1]; k++)
+        {
+            const int j   = Ht.colIdx[k];
+            Ht.values[k] *= tau * (1.0 + 0.3 * std::sin(double(i))) * (1.0 + 0.3 * std::sin(double(j)));
+            Ht.values[k] += i == j ? 1.0 : 0.0;
+        }
+    }
+    BF16CSRMatrix Ah(Ht);
+
+    double bf16Error = 0;
+    for (size_t k = 0; k < Ht.values.size(); k++)
+    {
+        bf16Error = std::max(bf16Error, std::abs(bf16ToFloat(Ah.values[k]) - Ht.values[k]) / std::abs(Ht.values[k]));
+    }
+    cout << "Heat step I + " << tau << " D A D, largest relative bf16 rounding of the entries " << bf16Error << endl;
+    assert(bf16Error > 1e-3 && "The bf16 matrix should differ from the double one");
+
+    start = high_resolution_clock::now();
+    xd    = conjugateGradient(Ht, b, VectorXd(VectorXd::Zero(b.size())), tol * b.norm(), maxIter);
+    td    = duration<double>(high_resolution_clock::now() - start).count();
+    Ht.apply(xd, r);
+    cout << "Double precision CG : rel. residual " << (b - r).norm() / b.norm() << ", " << td << " s" << endl;
+
+    x.setZero();
+    rep = mixedPrecisionSolve(Ht, Ah, b, x, tol, 1e-4f, 50, maxIter);
+    printReport("bf16 storage", rep);
+    assert(rep.relResidual < tol && "Mixed precision solve with bf16 inner CG did not converge");
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+#include "cg_kernels.hpp"
+#include "linear_operators.hpp"
+
+
+/// @brief Computes the solution of the linear system Ax = b using the pipelined conjugate gradient method (Ghysels & Vanroose). The matrix A is expected to be symmetric and positive definite (SPD).
+/// Both inner products of an iteration, (r, r) and (w, r), come out of the same fused vector update and form a single reduction, which does not depend on the following product q = A w.
+/// In a parallel setting that reduction can therefore be overlapped with the operator apply instead of serializing two reductions around it.
+/// The extra recurrences drift from the true residual, so every replaceEvery iterations, and before declaring convergence, r, w, s and z are recomputed from x and p (residual replacement).
+/// A convergence check that the true residual fails means the recursive one has drifted below it, e.g. for a tolerance under the attainable accuracy. The iteration goes on from the replaced residual, but stops at the tenth failed check instead of spending four operator applies on a check at nearly every iteration up to maxIter.
+/// The step after a replacement takes beta from A-conjugacy to the current p and alpha from the recomputed vectors, since gammaOld and alphaOld belong to the drifted recurrence and would mix the two.
+/// @param A is the linear operator of the system (see LinearOperator).
+/// @param b is the right hand side of the linear system.
+/// @param x0 is the initial guess of the solution.
+/// @param tol is the error tolerance of the method.
+/// @param maxIter is the maximum number of iterations.
+/// @param replaceEvery is the residual replacement period, 0 disables it.
+/// @return Estimation of the solution x.
+template<LinearOperator Op>
+Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1> pipelinedConjugateGradient(const Op&                                                    A,
+                                                                                  const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& b,
+                                                                                  const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& x0,
+                                                                                  const typename Op::Scalar&                                   tol,
+                                                                                  const int&                                                   maxIter,
+                                                                                  const int&                                                   replaceEvery = 20)
+{
+    using Scalar = typename Op::Scalar;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+    const int          maxFailedChecks = 10;
+    const Eigen::Index n = b.size();
+    Vector             x = x0;
+    Vector             r(n), w(n), q(n);
+    Vector             z = Vector::Zero(n);  // A s
+    Vector             s = Vector::Zero(n);  // A p
+    Vector             p = Vector::Zero(n);
+
+    A.apply(x, q);
+    r = b - q;
+    A.apply(r, w);
+    Scalar gamma    = r.squaredNorm();
+    Scalar delta    = w.dot(r);
+    Scalar gammaOld = 1, alphaOld = 1, alpha, beta;
+    Scalar pw = 0, ps = 0;     // (p, w) and (p, s) of the last residual replacement
+    bool   replaced     = false;
+    int    failedChecks = 0;  // convergence checks the true residual did not confirm
+
+    for (int k = 0; k < maxIter && std::sqrt(gamma) >= tol; k++)
+    {
+        A.apply(w, q);  // independent of the reduction (gamma, delta) above
+        if (k == 0)
+        {
+            beta  = 0;
+            alpha = gamma / delta;
+        }
+        else if (replaced)
+        {
+            // p_new = r + beta p with (p_new, A p) = 0, and (p_new, A p_new) = delta + 2 beta (p, w) + beta^2 (p, s)
+            beta     = -pw / ps;
+            alpha    = gamma / (delta + beta * pw);
+            replaced = false;
+        }
+        else
+        {
+            beta  = gamma / gammaOld;
+            alpha = gamma / (delta - beta * gamma / alphaOld);
+        }
+
+        // All recurrences and the next reduction in one pass over memory
+        Scalar gammaNew = 0, deltaNew = 0;
+#pragma omp parallel for reduction(+ : gammaNew, deltaNew) schedule(static)
+        for (Eigen::Index i = 0; i < n; i += kFusedChunk)
+        {
+            const Eigen::Index len = std::min(kFusedChunk, n - i);
+            z.segment(i, len) = q.segment(i, len) + beta * z.segment(i, len);
+            s.segment(i, len) = w.segment(i, len) + beta * s.segment(i, len);
+            p.segment(i, len) = r.segment(i, len) + beta * p.segment(i, len);
+            x.segment(i, len) += alpha * p.segment(i, len);
+            r.segment(i, len) -= alpha * s.segment(i, len);
+            w.segment(i, len) -= alpha * z.segment(i, len);
+            gammaNew += r.segment(i, len).squaredNorm();
+            deltaNew += w.segment(i, len).dot(r.segment(i, len));
+        }
+        gammaOld = gamma;
+        alphaOld = alpha;
+        gamma    = gammaNew;
+        delta    = deltaNew;
+
+        // Convergence of the recursive residual is confirmed on the true residual as well
+        const bool converged = std::sqrt(gamma) < tol;
+        if (converged || (replaceEvery > 0 && (k + 1) % replaceEvery == 0))
+        {
+            A.apply(x, q);
+            r = b - q;
+            A.apply(r, w);
+            A.apply(p, s);
+            A.apply(s, z);
+            gamma    = r.squaredNorm();
+            delta    = w.dot(r);
+            pw       = p.dot(w);
+            ps       = p.dot(s);
+            replaced = true;
+            if (converged && std::sqrt(gamma) >= tol && ++failedChecks == maxFailedChecks)
+            {
+                break;
+            }
+        }
+    }
+    return x;
+}
+
+
+/// @brief Computes the solution of the linear system Ax = b using the s-step conjugate gradient method. The matrix A is expected to be symmetric and positive definite (SPD).
+/// Each outer step builds the Krylov basis [r, A r, ..., A^{s-1} r] with s operator applies and no reduction, A-orthogonalizes it against the previous block, and takes s CG steps at once by solving a small (s, s) system.
+/// All inner products of an outer step are gathered in two batched reductions, i.e. two synchronizations per s iterations instead of two per iteration.
+/// The basis is scaled by an estimate of the largest eigenvalue of A to keep it well conditioned, and the residual is recomputed from x every replaceEvery outer steps.
+/// @param A is the linear operator of the system (see LinearOperator).
+/// @param b is the right hand side of the linear system.
+/// @param x0 is the initial guess of the solution.
+/// @param tol is the error tolerance of the method.
+/// @param maxIter is the maximum number of iterations, counted as operator applies.
+/// @param s is the number of steps per outer iteration, small values (2 to 5) are stable.
+/// @param replaceEvery is the residual replacement period in outer steps, 0 disables it.
+/// @return Estimation of the solution x.
+template<LinearOperator Op>
+Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1> sStepConjugateGradient(const Op&                                                    A,
+                                                                             const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& b,
+                                                                             const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& x0,
+                                                                             const typename Op::Scalar&                                   tol,
+                                                                             const int&                                                   maxIter,
+                                                                             const int&                                                   s            = 4,
+                                                                             const int&                                                   replaceEvery = 10)
+{
+    using Scalar = typename Op::Scalar;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+
+    const Eigen::Index n = b.size();
+    Vector             x = x0;
+    Vector             r(n), tmp(n), v(n);
+    Matrix             V(n, s + 1);  // scaled monomial basis, column j holds (A / sigma)^j r
+    Matrix             P(n, s), AP(n, s), Pold(n, s), APold(n, s);
+    Matrix             Wold(s, s);
+
+    // Largest eigenvalue estimate by a few power iterations, used to scale the basis
+    tmp          = Vector::Ones(n);
+    Scalar sigma = 1;
+    for (int i = 0; i < 10; i++)
+    {
+        A.apply(tmp, r);
+        sigma = r.norm() / tmp.norm();
+        tmp   = r / r.norm();
+    }
+
+    A.apply(x, tmp);
+    r              = b - tmp;
+    Scalar rr      = r.squaredNorm();
+    int    applies = 0;
+    for (int outer = 0; applies < maxIter && std::sqrt(rr) >= tol; outer++)
+    {
+        // Krylov basis, s operator applies without any reduction in between
+        V.col(0) = r;
+        v        = r;
+        for (int j = 0; j < s; j++)
+        {
+            A.apply(v, tmp);
+            v            = tmp / sigma;
+            V.col(j + 1) = v;
+        }
+        applies += s;
+        P  = V.leftCols(s);
+        AP = sigma * V.rightCols(s);
+
+        // First batched reduction: A-orthogonalize against the previous block
+        if (outer > 0)
+        {
+            Matrix C = APold.transpose() * P;
+            Matrix B = Wold.ldlt().solve(C);
+            P.noalias() -= Pold * B;
+            AP.noalias() -= APold * B;
+        }
+
+        // Second batched reduction: Gram matrix and projected residual
+        Matrix W = P.transpose() * AP;
+        Vector g = P.transpose() * r;
+        Vector a = W.ldlt().solve(g);
+
+        x.noalias() += P * a;
+        r.noalias() -= AP * a;
+        if (replaceEvery > 0 && (outer + 1) % replaceEvery == 0)
+        {
+            A.apply(x, tmp);
+            r = b - tmp;
+            applies++;
+        }
+        rr = r.squaredNorm();
+
+        Pold.swap(P);
+        APold.swap(AP);
+        Wold = W;
+    }
+    return x;
+}
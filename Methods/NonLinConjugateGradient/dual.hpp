@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cmath>
+#include <Eigen/Dense>
+#include "nonlinear_optimizers.hpp"
+
+
+/// @brief Dual number v + d * eps with eps^2 = 0 for forward-mode automatic differentiation. Evaluating
+/// f(x + eps * u) gives f(x) in the value and the directional derivative grad f(x).dot(u) in the derivative.
+/// Nesting, Dual<Dual<T>>, carries two directions and gives second directional derivatives u^T H w.
+/// @tparam T is the scalar type, possibly a Dual itself.
+template<typename T>
+struct Dual
+{
+    using Scalar = T;
+
+    T v;  // value
+    T d;  // derivative
+
+    Dual(const T& value = T(), const T& derivative = T())
+    : v(value)
+    , d(derivative)
+    {
+    }
+
+    Dual& operator+=(const Dual& b) { v += b.v; d += b.d; return *this; }
+    Dual& operator-=(const Dual& b) { v -= b.v; d -= b.d; return *this; }
+    Dual& operator*=(const Dual& b) { d = d * b.v + v * b.d; v *= b.v; return *this; }
+    Dual& operator/=(const Dual& b) { d = (d * b.v - v * b.d) / (b.v * b.v); v /= b.v; return *this; }
+
+    friend Dual operator-(const Dual& a) { return Dual(-a.v, -a.d); }
+    friend Dual operator+(const Dual& a) { return a; }
+
+    friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+    friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+    friend Dual operator*(Dual a, const Dual& b) { return a *= b; }
+    friend Dual operator/(Dual a, const Dual& b) { return a /= b; }
+
+    // mixed operations with the scalar type skip the products with a zero derivative
+    friend Dual operator+(const Dual& a, const T& b) { return Dual(a.v + b, a.d); }
+    friend Dual operator+(const T& a, const Dual& b) { return Dual(a + b.v, b.d); }
+    friend Dual operator-(const Dual& a, const T& b) { return Dual(a.v - b, a.d); }
+    friend Dual operator-(const T& a, const Dual& b) { return Dual(a - b.v, -b.d); }
+    friend Dual operator*(const Dual& a, const T& b) { return Dual(a.v * b, a.d * b); }
+    friend Dual operator*(const T& a, const Dual& b) { return Dual(a * b.v, a * b.d); }
+    friend Dual operator/(const Dual& a, const T& b) { return Dual(a.v / b, a.d / b); }
+    friend Dual operator/(const T& a, const Dual& b) { return Dual(a / b.v, -a * b.d / (b.v * b.v)); }
+
+    // comparisons look at the value only, so branches follow the primal computation
+    friend bool operator==(const Dual& a, const Dual& b) { return a.v == b.v; }
+    friend bool operator!=(const Dual& a, const Dual& b) { return a.v != b.v; }
+    friend bool operator<(const Dual& a, const Dual& b) { return a.v < b.v; }
+    friend bool operator<=(const Dual& a, const Dual& b) { return a.v <= b.v; }
+    friend bool operator>(const Dual& a, const Dual& b) { return a.v > b.v; }
+    friend bool operator>=(const Dual& a, const Dual& b) { return a.v >= b.v; }
+
+    // elementary functions, the inner calls resolve through ADL for nested duals
+    friend Dual sqrt(const Dual& a)
+    {
+        using std::sqrt;
+        const T s = sqrt(a.v);
+        return Dual(s, a.d / (T(2) * s));
+    }
+    friend Dual exp(const Dual& a)
+    {
+        using std::exp;
+        const T e = exp(a.v);
+        return Dual(e, a.d * e);
+    }
+    friend Dual log(const Dual& a)
+    {
+        using std::log;
+        return Dual(log(a.v), a.d / a.v);
+    }
+    friend Dual sin(const Dual& a)
+    {
+        using std::cos;
+        using std::sin;
+        return Dual(sin(a.v), a.d * cos(a.v));
+    }
+    friend Dual cos(const Dual& a)
+    {
+        using std::cos;
+        using std::sin;
+        return Dual(cos(a.v), -a.d * sin(a.v));
+    }
+    friend Dual tanh(const Dual& a)
+    {
+        using std::tanh;
+        const T t = tanh(a.v);
+        return Dual(t, a.d * (T(1) - t * t));
+    }
+    friend Dual atan(const Dual& a)
+    {
+        using std::atan;
+        return Dual(atan(a.v), a.d / (T(1) + a.v * a.v));
+    }
+    friend Dual abs(const Dual& a) { return a.v < T(0) ? -a : a; }
+    friend Dual pow(const Dual& a, const T& p)
+    {
+        using std::pow;
+        const T q = pow(a.v, p - T(1));
+        return Dual(q * a.v, a.d * p * q);
+    }
+};
+
+
+namespace Eigen
+{
+
+/// @brief Lets Eigen matrices hold dual numbers, so objectives can be written with Eigen expressions.
+template<typename T>
+struct NumTraits<Dual<T>> : NumTraits<T>
+{
+    typedef Dual<T> Real;
+    typedef Dual<T> NonInteger;
+    typedef Dual<T> Nested;
+    typedef Dual<T> Literal;
+
+    enum
+    {
+        IsComplex             = 0,
+        IsInteger             = 0,
+        IsSigned              = 1,
+        RequireInitialization = 1,
+        ReadCost              = 2 * NumTraits<T>::ReadCost,
+        AddCost               = 2 * NumTraits<T>::AddCost,
+        MulCost               = 3 * NumTraits<T>::MulCost,
+    };
+};
+
+}  // namespace Eigen
+
+
+/// @brief Computes f(x) and grad f(x) with forward-mode AD, one dual pass per component of x, i.e. n evaluations of f.
+/// @param func is a callable templated on the scalar type, S func(const Eigen::Matrix<S, Eigen::Dynamic, 1>&).
+/// @param x is the point.
+/// @param g is the gradient on exit.
+/// @return f(x).
+template<typename T, typename Func>
+T autodiffGradient(const Func& func, const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, Eigen::Matrix<T, Eigen::Dynamic, 1>& g)
+{
+    const Eigen::Index                        n  = x.size();
+    Eigen::Matrix<Dual<T>, Eigen::Dynamic, 1> xd = x.template cast<Dual<T>>();
+    g.resize(n);
+    T f = T(0);
+    for (Eigen::Index i = 0; i < n; i++)
+    {
+        xd(i).d         = T(1);
+        const Dual<T> y = func(xd);
+        xd(i).d         = T(0);
+        g(i)            = y.d;
+        f               = y.v;
+    }
+    return f;
+}
+
+
+/// @brief Computes the Hessian-vector product H(x) * u with nested forward-mode AD, without forming H.
+/// The outer dual carries u, the inner one e_i, so each pass gives e_i^T H u; n evaluations of f and O(n) memory.
+/// @param func is a callable templated on the scalar type, S func(const Eigen::Matrix<S, Eigen::Dynamic, 1>&).
+/// @param x is the point.
+/// @param u is the direction.
+/// @param Hu is the product on exit.
+template<typename T, typename Func>
+void autodiffHessianVector(const Func&                                func,
+                           const Eigen::Matrix<T, Eigen::Dynamic, 1>& x,
+                           const Eigen::Matrix<T, Eigen::Dynamic, 1>& u,
+                           Eigen::Matrix<T, Eigen::Dynamic, 1>&       Hu)
+{
+    using D2 = Dual<Dual<T>>;
+
+    const Eigen::Index                   n = x.size();
+    Eigen::Matrix<D2, Eigen::Dynamic, 1> xd(n);
+    for (Eigen::Index i = 0; i < n; i++)
+    {
+        xd(i) = D2(Dual<T>(x(i)), Dual<T>(u(i)));
+    }
+    Hu.resize(n);
+    for (Eigen::Index i = 0; i < n; i++)
+    {
+        xd(i).v.d = T(1);
+        Hu(i)     = func(xd).d.d;
+        xd(i).v.d = T(0);
+    }
+}
+
+
+/// @brief Computes the curvature u^T H(x) u along one direction in a single nested dual pass.
+/// This is what a Newton-Raphson step along a search direction needs.
+/// @param func is a callable templated on the scalar type, S func(const Eigen::Matrix<S, Eigen::Dynamic, 1>&).
+/// @param x is the point.
+/// @param u is the direction.
+/// @return u^T H(x) u.
+template<typename T, typename Func>
+T autodiffCurvature(const Func& func, const Eigen::Matrix<T, Eigen::Dynamic, 1>& x, const Eigen::Matrix<T, Eigen::Dynamic, 1>& u)
+{
+    using D2 = Dual<Dual<T>>;
+
+    Eigen::Matrix<D2, Eigen::Dynamic, 1> xd(x.size());
+    for (Eigen::Index i = 0; i < x.size(); i++)
+    {
+        xd(i) = D2(Dual<T>(x(i), u(i)), Dual<T>(u(i)));
+    }
+    return func(xd).d.d;
+}
+
+
+/// @brief Builds an Objective from a single templated function: the value in plain arithmetic, the gradient,
+/// the Hessian-vector product and the curvature along a direction by forward-mode AD.
+/// @param func is a callable templated on the scalar type, S func(const Eigen::Matrix<S, Eigen::Dynamic, 1>&), copied into the objective.
+/// @return The objective.
+template<typename T, typename Func>
+Objective<T> autodiffObjective(const Func& func)
+{
+    using Vector = typename Objective<T>::Vector;
+
+    Objective<T> obj;
+    obj.value         = [func](const Vector& x) { return func(x); };
+    obj.valueGradient = [func](const Vector& x, Vector& g) { return autodiffGradient(func, x, g); };
+    obj.hessianVector = [func](const Vector& x, const Vector& u, Vector& Hu) { autodiffHessianVector(func, x, u, Hu); };
+    obj.curvature     = [func](const Vector& x, const Vector& u) { return autodiffCurvature(func, x, u); };
+    return obj;
+}
@@ -1,119 +1,167 @@
+#include <cassert>
+#include <cmath>
 #include <iostream>
-#include <functional>
 #include <Eigen/Dense>
 
-using Eigen::MatrixXf;
-using Eigen::VectorXf;
+#include "dual.hpp"
+#include "nonlinear_optimizers.hpp"
+
+using Eigen::Vector2d;
+using Eigen::VectorXd;
 using std::cout;
 using std::endl;
 
 
-/// @brief Computes the solution that minimizes a non linear function using the non-linear conjugate
-/// gradient method. The function is expected to be well-behaved.
-/// @param func is the function to be minimized.
-/// @param dFunc is the function that computes the gradient of the function to be minimized.
-/// @param ddFunc is the function that computes the Hessian of the function to be minimized.
-/// @param x0 is the initial guess of the solution.
-/// @param tolCG is the error tolerance of the conjugate gradient part.
-/// @param tolNR is the error tolerance of the Newton-Raphson part.
-/// @param maxIterCG is the maximum number of conjugate gradient iterations.
-/// @param maxIterNR is the maximum number of Newton-Raphson iterations.
-/// @return The estimation of the solution.
-VectorXf nonLinConjugateGradient(std::function<VectorXf(VectorXf)> func,
-                                 std::function<VectorXf(VectorXf)> dFunc,
-                                 std::function<MatrixXf(VectorXf)> ddFunc,
-                                 const VectorXf&                   x0,
-                                 const float&                      tolCG,
-                                 const float&                      tolNR,
-                                 const u_int&                      maxIterCG,
-                                 const u_int&                      maxIterNR)
+/// @brief Function whose squared norm is minimized, with roots at (+-1, 0).
+/// @param x is the input vector.
+/// @return The output vector.
+Vector2d func(const VectorXd& x)
 {
-    u_int       kCG = 0;
-    u_int       kNR = 0;
-    const u_int n   = x0.size();
-    u_int       kN  = 0;
+    // Simple non linear function
+    Vector2d y;
+    y(0) = x(0) * x(0) + x(1) * x(1) - 1;
+    y(1) = x(0) * x(0) - x(1) * x(1) - 1;
+    return y;
+}
 
-    VectorXf r = -dFunc(x0);
-    VectorXf d = r;
 
-    float    deltaNew = r.dot(r);
-    float    delta0   = deltaNew;
-    float    deltaD, alpha, deltaOld, beta;
-    VectorXf x;
+/// @brief Value and gradient of 0.5 * |func(x)|^2, the gradient being J^T func(x).
+/// @param x is the input vector.
+/// @param g is the gradient on exit.
+/// @return The value.
+double leastSquares(const VectorXd& x, VectorXd& g)
+{
+    Vector2d        y = func(x);
+    Eigen::Matrix2d J;
+    J << 2 * x(0),  2 * x(1),
+         2 * x(0), -2 * x(1);
+    g = J.transpose() * y;
+    return 0.5 * y.squaredNorm();
+}
+
 
-    while (kCG < maxIterCG && deltaNew > tolCG * tolCG * delta0)
+/// @brief Extended Rosenbrock function written once for any scalar type, so AD can differentiate it.
+template<typename S>
+S rosenbrockGeneric(const Eigen::Matrix<S, Eigen::Dynamic, 1>& x)
+{
+    S f = S(0);
+    for (Eigen::Index i = 0; i + 1 < x.size(); i += 2)
     {
-        kNR    = 0;
-        deltaD = d.dot(d);
-        while (kNR < maxIterNR && alpha * alpha * deltaD > tolNR * tolNR)
-        {
-            alpha = -dFunc(x0).dot(d) / d.dot(ddFunc(x0) * d);
-            x     = x + alpha * d;
-            kNR++;
-        }
-        r        = -dFunc(x0);
-        deltaOld = deltaNew;
-        deltaNew = r.dot(r);
-        beta     = deltaNew / deltaOld;
-        d        = r + beta * d;
-        kCG++;
-        if (kN == 50 || r.dot(d) <= 0)
-        {
-            d  = r;
-            kN = 0;
-        }
-        kCG++;
+        const S a = x(i + 1) - x(i) * x(i);
+        const S b = 1.0 - x(i);
+        f += 100.0 * a * a + b * b;
     }
-    return x;
+    return f;
 }
 
 
-/// @brief Function to be fed in the non linear conjugate gradient method.
-/// @param x is the input vector.
-/// @return The output vector.
-VectorXf func(VectorXf x)
+/// @brief Value of the extended Rosenbrock function, sum of 100 (x_{2i+1} - x_{2i}^2)^2 + (1 - x_{2i})^2.
+double rosenbrock(const VectorXd& x)
 {
-    // Simple non linear function
-    VectorXf y(x.size());
-    y(0) = x(0) * x(0) + x(1) * x(1) - 1;
-    y(1) = x(0) * x(0) - x(1) * x(1) - 1;
-    return y;
+    double f = 0;
+    for (Eigen::Index i = 0; i + 1 < x.size(); i += 2)
+    {
+        const double a = x(i + 1) - x(i) * x(i);
+        const double b = 1 - x(i);
+        f += 100 * a * a + b * b;
+    }
+    return f;
 }
 
-VectorXf dfunc(VectorXf x)
+
+/// @brief Value and gradient of the extended Rosenbrock function.
+double rosenbrockGradient(const VectorXd& x, VectorXd& g)
 {
-    // Simple non linear function
-    VectorXf y(x.size());
-    y(0) = x(0) * x(0) + x(1) * x(1) - 1;
-    y(1) = x(0) * x(0) - x(1) * x(1) - 1;
-    return y;
+    g.setZero(x.size());
+    for (Eigen::Index i = 0; i + 1 < x.size(); i += 2)
+    {
+        const double a = x(i + 1) - x(i) * x(i);
+        g(i)           = -400 * a * x(i) - 2 * (1 - x(i));
+        g(i + 1)       = 200 * a;
+    }
+    return rosenbrock(x);
 }
 
-MatrixXf ddfunc(VectorXf x)
+
+void report(const char* name, const OptimizerReport& r)
 {
-    // Simple non linear function
-    VectorXf y(x.size());
-    y(0) = x(0) * x(0) + x(1) * x(1) - 1;
-    y(1) = x(0) * x(0) - x(1) * x(1) - 1;
-    return y * y.transpose();
+    cout << name << " : " << r.iterations << " iterations, " << r.valueEvals << " value, " << r.gradientEvals
+         << " gradient and " << r.hessianEvals << " Hessian evaluations, f = " << r.value << ", |g| = " << r.gradNorm << endl;
 }
 
 
 int main()  // int argc, char* argv[])
-{   
-    VectorXf x0(3);
-    x0.setZero();
-
-    float tol     = 1e-2;
-    int   maxIter = 1000;
+{
+    Objective<double> small;
+    small.valueGradient = leastSquares;
+    VectorXd x0(2);
+    x0 << 0.5, 0.5;
 
-// FIXME: Sometimes Assertion failed: (aLhs.rows() == aRhs.rows() && aLhs.cols() == aRhs.cols()), function CwiseBinaryOp, file CwiseBinaryOp.h, line 116. Other times, the program runs but fails to print x to output.
-    VectorXf x = nonLinConjugateGradient(func, dfunc, ddfunc, x0, tol, tol, maxIter, maxIter);
+    OptimizerOptions<double> opts;
+    opts.gradTol = 1e-8;
 
+    VectorXd        x = x0;
+    OptimizerReport r = nonLinConjugateGradient(small, x, opts);
+    report("PR+ CG", r);
     cout << "This is the initial vector x0 : " << endl;
     cout << x0 << endl;
     cout << "This is the found solution vector x : " << endl;
     cout << x << endl;
+    // the root is degenerate (f grows like x(1)^4), so x(1) is only accurate to about the fourth root of f
+    assert(r.converged && r.value < 1e-10 && std::abs(std::abs(x(0)) - 1) < 1e-3 && "Nonlinear CG did not find a root");
+
+    // Extended Rosenbrock, the value alone is enough to reject trial steps
+    const int         n = 1000;
+    Objective<double> rosen;
+    rosen.value         = rosenbrock;
+    rosen.valueGradient = rosenbrockGradient;
+    VectorXd xr0(n);
+    for (int i = 0; i < n; i += 2)
+    {
+        xr0(i)     = -1.2;
+        xr0(i + 1) = 1;
+    }
+
+    x = xr0;
+    r = nonLinConjugateGradient(rosen, x, opts, CGUpdate::PolakRibierePlus);
+    report("Rosenbrock PR+ CG", r);
+    assert(r.converged && (x - VectorXd::Ones(n)).norm() < 1e-4 && "PR+ CG did not converge on Rosenbrock");
+
+    x = xr0;
+    r = nonLinConjugateGradient(rosen, x, opts, CGUpdate::FletcherReeves);
+    report("Rosenbrock FR CG ", r);
+
+    x = xr0;
+    r = lbfgs(rosen, x, opts);
+    report("Rosenbrock L-BFGS", r);
+    assert(r.converged && (x - VectorXd::Ones(n)).norm() < 1e-4 && "L-BFGS did not converge on Rosenbrock");
+
+    // Same function differentiated by forward-mode AD: no hand-coded gradient and no dense Hessian
+    const int         nAD  = 200;
+    auto              func = [](const auto& v) { return rosenbrockGeneric(v); };
+    Objective<double> ad   = autodiffObjective<double>(func);
+
+    VectorXd xa = xr0.head(nAD), gHand, gAD, u = VectorXd::LinSpaced(nAD, -1, 1), Hu, gPlus, gMinus;
+    rosenbrockGradient(xa, gHand);
+    autodiffGradient(func, xa, gAD);
+    assert((gAD - gHand).norm() < 1e-10 * gHand.norm() && "AD gradient differs from the hand-coded one");
+
+    const double h = 1e-6;
+    autodiffHessianVector(func, xa, u, Hu);
+    rosenbrockGradient(VectorXd(xa + h * u), gPlus);
+    rosenbrockGradient(VectorXd(xa - h * u), gMinus);
+    assert((Hu - (gPlus - gMinus) / (2 * h)).norm() < 1e-5 * Hu.norm() && "AD Hessian-vector product differs from finite differences");
+    assert(std::abs(autodiffCurvature(func, xa, u) - u.dot(Hu)) < 1e-8 * std::abs(u.dot(Hu)) && "AD curvature differs from u^T H u");
+
+    x = xa;
+    r = nonLinConjugateGradient(ad, x, opts);
+    report("AD Rosenbrock PR+ CG with Newton-Raphson step", r);
+    assert(r.converged && (x - VectorXd::Ones(nAD)).norm() < 1e-4 && "AD nonlinear CG did not converge");
+
+    x = xa;
+    r = newtonConjugateGradient(ad, x, opts);
+    report("AD Rosenbrock Newton-CG", r);
+    assert(r.converged && (x - VectorXd::Ones(nAD)).norm() < 1e-4 && "Newton-CG did not converge");
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <Eigen/Dense>
+
+
+/// @brief Objective function of an unconstrained minimization problem.
+/// valueGradient is required; value is optional and lets the line search reject trial points without
+/// paying for a gradient. The second order members are optional and matrix-free: hessianVector for
+/// Newton-CG, curvature (or else hessianVector) for the Newton-Raphson step of the nonlinear CG.
+template<typename T>
+struct Objective
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    std::function<T(const Vector&)>                            value;          // f(x)
+    std::function<T(const Vector&, Vector&)>                   valueGradient;  // returns f(x) and writes grad f(x)
+    std::function<void(const Vector&, const Vector&, Vector&)> hessianVector;  // writes H(x) * u
+    std::function<T(const Vector&, const Vector&)>             curvature;      // returns u^T H(x) u
+};
+
+
+/// @brief Options shared by the optimizers.
+template<typename T>
+struct OptimizerOptions
+{
+    T   gradTol       = T(1e-6);  // stop when |grad f| <= gradTol * max(1, |grad f(x0)|)
+    int maxIter       = 1000;
+    T   c1            = T(1e-4);  // sufficient decrease constant of the Wolfe conditions
+    T   c2            = T(-1);    // curvature constant, -1 selects 0.1 for CG and 0.9 for L-BFGS
+    int maxLineSearch = 25;       // function evaluations per line search
+    int restartEvery  = 0;        // CG restart period, 0 selects the problem size
+    int memory        = 10;       // L-BFGS correction pairs
+    int maxInner      = 100;      // inner CG iterations of Newton-CG
+};
+
+
+/// @brief Outcome of an optimizer run. The evaluation counters are the cost measure, since function
+/// and gradient evaluations usually dominate the run time.
+struct OptimizerReport
+{
+    int    iterations    = 0;
+    long   valueEvals    = 0;  // calls to value
+    long   gradientEvals = 0;  // calls to valueGradient
+    long   hessianEvals  = 0;  // calls to hessianVector or curvature
+    double value         = 0;
+    double gradNorm      = 0;
+    bool   converged     = false;
+};
+
+
+/// @brief Update formula of the nonlinear conjugate gradient direction.
+enum class CGUpdate
+{
+    FletcherReeves,
+    PolakRibierePlus,
+};
+
+
+namespace detail
+{
+
+/// @brief Wraps an Objective to count evaluations.
+template<typename T>
+struct CountedObjective
+{
+    using Vector = typename Objective<T>::Vector;
+
+    const Objective<T>& obj;
+    OptimizerReport&    report;
+
+    bool hasValue() const { return static_cast<bool>(obj.value); }
+
+    T value(const Vector& x)
+    {
+        report.valueEvals++;
+        return obj.value(x);
+    }
+
+    T valueGradient(const Vector& x, Vector& g)
+    {
+        report.gradientEvals++;
+        return obj.valueGradient(x, g);
+    }
+
+    bool hasCurvature() const { return obj.curvature || obj.hessianVector; }
+
+    T curvature(const Vector& x, const Vector& u)
+    {
+        report.hessianEvals++;
+        if (obj.curvature)
+        {
+            return obj.curvature(x, u);
+        }
+        Vector Hu;
+        obj.hessianVector(x, u, Hu);
+        return u.dot(Hu);
+    }
+
+    void hessianVector(const Vector& x, const Vector& u, Vector& Hu)
+    {
+        report.hessianEvals++;
+        obj.hessianVector(x, u, Hu);
+    }
+};
+
+
+/// @brief Line search along d from x satisfying the strong Wolfe conditions (Nocedal & Wright, Alg. 3.5 and 3.6).
+/// The accepted point comes back with its value and gradient, so the caller never evaluates it twice,
+/// and trial points that fail sufficient decrease are rejected on the value alone.
+/// @param f is the counted objective.
+/// @param x is the current point.
+/// @param fx is f(x).
+/// @param gd is grad f(x).dot(d), negative for a descent direction.
+/// @param d is the search direction.
+/// @param alpha is the initial step on entry and the accepted step on exit.
+/// @param xNew is the accepted point on exit.
+/// @param fNew is f(xNew) on exit.
+/// @param gNew is grad f(xNew) on exit.
+/// @return Whether the strong Wolfe conditions were met; otherwise the best point found is returned.
+template<typename T>
+bool wolfeLineSearch(CountedObjective<T>&                          f,
+                     const typename CountedObjective<T>::Vector&  x,
+                     const T&                                      fx,
+                     const T&                                      gd,
+                     const typename CountedObjective<T>::Vector&  d,
+                     T&                                            alpha,
+                     typename CountedObjective<T>::Vector&        xNew,
+                     T&                                            fNew,
+                     typename CountedObjective<T>::Vector&        gNew,
+                     const OptimizerOptions<T>&                    opts,
+                     const T&                                      c2)
+{
+    assert(opts.maxLineSearch > 0 && "The line search needs at least one function evaluation");
+    int evals  = 0;
+    T   gradAt = -1;  // step at which xNew, fNew and gNew are valid
+    fNew       = fx;  // no step taken yet, so a search without evaluations reports no decrease
+
+    typename CountedObjective<T>::Vector xTrial;
+
+    // Value at a trial step, gradient only when it is needed for the curvature test or comes for free
+    auto phi = [&](const T& a) {
+        evals++;
+        if (f.hasValue())
+        {
+            xTrial = x + a * d;
+            return f.value(xTrial);
+        }
+        xNew   = x + a * d;
+        fNew   = f.valueGradient(xNew, gNew);
+        gradAt = a;
+        return fNew;
+    };
+    auto dphi = [&](const T& a) {
+        if (gradAt != a)
+        {
+            xNew   = x + a * d;
+            fNew   = f.valueGradient(xNew, gNew);
+            gradAt = a;
+        }
+        return gNew.dot(d);
+    };
+
+    // zoom keeps lo as the best step satisfying sufficient decrease, with its value and slope known
+    auto zoom = [&](T lo, T fLo, T dLo, T hi, T fHi) {
+        while (evals < opts.maxLineSearch)
+        {
+            const T width = hi - lo;
+            const T denom = T(2) * (fHi - fLo - dLo * width);
+            T       a     = denom > T(0) ? lo - dLo * width * width / denom : lo + width / T(2);
+            const T lower = std::min(lo + T(0.1) * width, lo + T(0.9) * width);
+            const T upper = std::max(lo + T(0.1) * width, lo + T(0.9) * width);
+            a             = std::clamp(a, lower, upper);
+
+            const T fa = phi(a);
+            if (fa > fx + opts.c1 * a * gd || fa >= fLo)
+            {
+                hi  = a;
+                fHi = fa;
+                continue;
+            }
+            const T da = dphi(a);
+            if (std::abs(da) <= -c2 * gd)
+            {
+                alpha = a;
+                return true;
+            }
+            if (da * width >= T(0))
+            {
+                hi  = lo;
+                fHi = fLo;
+            }
+            lo  = a;
+            fLo = fa;
+            dLo = da;
+        }
+        // out of evaluations: fall back to the best step with sufficient decrease
+        alpha = lo;
+        if (lo > T(0))
+        {
+            dphi(lo);
+        }
+        else
+        {
+            xNew = x;
+            fNew = f.valueGradient(xNew, gNew);
+        }
+        return false;
+    };
+
+    T aPrev = 0;
+    T fPrev = fx;
+    T dPrev = gd;
+    T a     = alpha;
+    while (evals < opts.maxLineSearch)
+    {
+        const T fa = phi(a);
+        if (fa > fx + opts.c1 * a * gd || (aPrev > T(0) && fa >= fPrev))
+        {
+            return zoom(aPrev, fPrev, dPrev, a, fa);
+        }
+        const T da = dphi(a);
+        if (std::abs(da) <= -c2 * gd)
+        {
+            alpha = a;
+            return true;
+        }
+        if (da >= T(0))
+        {
+            return zoom(a, fa, da, aPrev, fPrev);
+        }
+        aPrev = a;
+        fPrev = fa;
+        dPrev = da;
+        a *= T(2);
+    }
+    // the step kept growing: accept the last one, its gradient is already in gNew
+    alpha = aPrev;
+    return false;
+}
+
+}  // namespace detail
+
+
+/// @brief Minimizes a smooth function with the nonlinear conjugate gradient method and a strong Wolfe line search.
+/// The gradient at the accepted point of each line search is the gradient of the next iteration, so every iteration
+/// costs one line search and nothing else. Restarts on steepest descent every restartEvery iterations or when the
+/// direction is not a descent direction. When the objective provides second order information, the first trial step of
+/// each line search is the Newton-Raphson step -grad f.dot(d) / (d^T H d) along d.
+/// @param obj is the objective function.
+/// @param x is the initial guess on entry and the estimation of the minimizer on exit.
+/// @param opts are the stopping criteria and line search constants.
+/// @param update is the formula for beta.
+/// @return The iteration and evaluation counts and the final value and gradient norm.
+template<typename T>
+OptimizerReport nonLinConjugateGradient(const Objective<T>&                 obj,
+                                        Eigen::Matrix<T, Eigen::Dynamic, 1>& x,
+                                        const OptimizerOptions<T>&          opts   = OptimizerOptions<T>(),
+                                        const CGUpdate&                     update = CGUpdate::PolakRibierePlus)
+{
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    OptimizerReport             report;
+    detail::CountedObjective<T> f{obj, report};
+    const Eigen::Index          n       = x.size();
+    const T                     c2      = opts.c2 > T(0) ? opts.c2 : T(0.1);
+    const int                   restart = opts.restartEvery > 0 ? opts.restartEvery : static_cast<int>(n);
+
+    Vector  g(n), gNew(n), xNew(n);
+    T       fx    = f.valueGradient(x, g);
+    Vector  d     = -g;
+    T       gg    = g.squaredNorm();
+    T       gd    = -gg;
+    T       alpha = T(1) / std::max(std::sqrt(gg), T(1));
+    T       fNew;
+    const T tol   = opts.gradTol * std::max(T(1), std::sqrt(gg));
+
+    int sinceRestart = 0;
+    while (report.iterations < opts.maxIter && std::sqrt(gg) > tol)
+    {
+        if (f.hasCurvature())
+        {
+            const T dHd = f.curvature(x, d);
+            if (dHd > T(0))
+            {
+                alpha = -gd / dHd;
+            }
+        }
+        const bool ok = detail::wolfeLineSearch(f, x, fx, gd, d, alpha, xNew, fNew, gNew, opts, c2);
+        if (!ok && !(fNew < fx))
+        {
+            break;  // no progress along d
+        }
+        report.iterations++;
+        sinceRestart++;
+
+        const T ggNew = gNew.squaredNorm();
+        T       beta  = update == CGUpdate::FletcherReeves ? ggNew / gg : std::max(T(0), (ggNew - gNew.dot(g)) / gg);
+        if (sinceRestart >= restart)
+        {
+            beta         = T(0);
+            sinceRestart = 0;
+        }
+        x.swap(xNew);
+        g.swap(gNew);
+        fx = fNew;
+        gg = ggNew;
+
+        d        = -g + beta * d;
+        T gdNext = g.dot(d);
+        if (gdNext >= T(0))
+        {
+            d            = -g;
+            gdNext       = -gg;
+            sinceRestart = 0;
+        }
+        // initial step of the next search from the first-order change of the previous one
+        alpha *= gd / gdNext;
+        gd = gdNext;
+    }
+    report.value     = fx;
+    report.gradNorm  = std::sqrt(gg);
+    report.converged = std::sqrt(gg) <= tol;
+    return report;
+}
+
+
+/// @brief Minimizes a smooth function with the limited-memory BFGS method and a strong Wolfe line search.
+/// Keeps the last opts.memory correction pairs, so memory is O(opts.memory * n) and the direction costs
+/// O(opts.memory * n) per iteration via the two-loop recursion.
+/// @param obj is the objective function.
+/// @param x is the initial guess on entry and the estimation of the minimizer on exit.
+/// @param opts are the stopping criteria, line search constants and memory.
+/// @return The iteration and evaluation counts and the final value and gradient norm.
+template<typename T>
+OptimizerReport lbfgs(const Objective<T>&                 obj,
+                      Eigen::Matrix<T, Eigen::Dynamic, 1>& x,
+                      const OptimizerOptions<T>&          opts = OptimizerOptions<T>())
+{
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+    OptimizerReport             report;
+    detail::CountedObjective<T> f{obj, report};
+    const Eigen::Index          n  = x.size();
+    const int                   m  = std::max(opts.memory, 1);
+    const T                     c2 = opts.c2 > T(0) ? opts.c2 : T(0.9);
+
+    Matrix S(n, m), Y(n, m);  // ring buffers of s = x_{k+1} - x_k and y = g_{k+1} - g_k
+    Vector rho(m), a(m);
+    int    stored = 0;
+    int    head   = 0;  // next slot to overwrite
+
+    Vector  g(n), gNew(n), xNew(n), d(n);
+    T       fx = f.valueGradient(x, g);
+    T       fNew;
+    const T tol = opts.gradTol * std::max(T(1), g.norm());
+
+    while (report.iterations < opts.maxIter && g.norm() > tol)
+    {
+        // two-loop recursion, newest pair first
+        d = -g;
+        for (int i = 0; i < stored; i++)
+        {
+            const int j = (head - 1 - i + m) % m;
+            a(j)        = rho(j) * S.col(j).dot(d);
+            d -= a(j) * Y.col(j);
+        }
+        if (stored > 0)
+        {
+            const int j = (head - 1 + m) % m;
+            d *= S.col(j).dot(Y.col(j)) / Y.col(j).squaredNorm();
+        }
+        for (int i = stored - 1; i >= 0; i--)
+        {
+            const int j = (head - 1 - i + m) % m;
+            d += (a(j) - rho(j) * Y.col(j).dot(d)) * S.col(j);
+        }
+
+        T gd = g.dot(d);
+        if (gd >= T(0))
+        {
+            d      = -g;
+            gd     = -g.squaredNorm();
+            stored = 0;
+        }
+        T alpha = stored > 0 ? T(1) : T(1) / std::max(g.norm(), T(1));
+
+        const bool ok = detail::wolfeLineSearch(f, x, fx, gd, d, alpha, xNew, fNew, gNew, opts, c2);
+        if (!ok && !(fNew < fx))
+        {
+            break;  // no progress along d
+        }
+        report.iterations++;
+
+        // keep the pair only if the curvature condition holds, so the implicit Hessian stays SPD
+        S.col(head) = xNew - x;
+        Y.col(head) = gNew - g;
+        const T sy  = S.col(head).dot(Y.col(head));
+        if (sy > std::numeric_limits<T>::epsilon() * S.col(head).norm() * Y.col(head).norm())
+        {
+            rho(head) = T(1) / sy;
+            head      = (head + 1) % m;
+            stored    = std::min(stored + 1, m);
+        }
+        x.swap(xNew);
+        g.swap(gNew);
+        fx = fNew;
+    }
+    report.value     = fx;
+    report.gradNorm  = g.norm();
+    report.converged = g.norm() <= tol;
+    return report;
+}
+
+
+/// @brief Minimizes a smooth function with the line search Newton-CG method (Nocedal & Wright, Alg. 7.1).
+/// The Newton system H p = -grad f is solved inexactly by CG with the matrix-free obj.hessianVector, stopping at
+/// a relative residual min(0.5, sqrt(|grad f|)) or at the first direction of nonpositive curvature, so the Hessian
+/// is never formed and memory stays O(n).
+/// @param obj is the objective function, hessianVector is required.
+/// @param x is the initial guess on entry and the estimation of the minimizer on exit.
+/// @param opts are the stopping criteria, line search constants and inner iteration limit.
+/// @return The iteration and evaluation counts and the final value and gradient norm.
+template<typename T>
+OptimizerReport newtonConjugateGradient(const Objective<T>&                 obj,
+                                        Eigen::Matrix<T, Eigen::Dynamic, 1>& x,
+                                        const OptimizerOptions<T>&          opts = OptimizerOptions<T>())
+{
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    OptimizerReport             report;
+    detail::CountedObjective<T> f{obj, report};
+    const Eigen::Index          n  = x.size();
+    const T                     c2 = opts.c2 > T(0) ? opts.c2 : T(0.9);
+
+    Vector  g(n), gNew(n), xNew(n), p(n), z(n), r(n), d(n), Hd(n);
+    T       fx = f.valueGradient(x, g);
+    T       fNew;
+    const T tol = opts.gradTol * std::max(T(1), g.norm());
+
+    while (report.iterations < opts.maxIter && g.norm() > tol)
+    {
+        // inexact Newton step by CG on H p = -g
+        const T gNorm = g.norm();
+        const T eta   = std::min(T(0.5), std::sqrt(gNorm)) * gNorm;
+        z.setZero();
+        r    = g;
+        d    = -r;
+        T rr = r.squaredNorm();
+        for (int j = 0; j < opts.maxInner; j++)
+        {
+            f.hessianVector(x, d, Hd);
+            const T dHd = d.dot(Hd);
+            if (dHd <= T(0))
+            {
+                break;  // nonpositive curvature, keep the step so far
+            }
+            const T a = rr / dHd;
+            z += a * d;
+            r += a * Hd;
+            const T rrNew = r.squaredNorm();
+            if (std::sqrt(rrNew) < eta)
+            {
+                break;
+            }
+            d  = -r + (rrNew / rr) * d;
+            rr = rrNew;
+        }
+        const bool newton = z.squaredNorm() > T(0);
+        p                 = newton ? z : Vector(-g);
+
+        T          alpha = newton ? T(1) : T(1) / std::max(gNorm, T(1));
+        const T    gp    = g.dot(p);
+        const bool ok    = detail::wolfeLineSearch(f, x, fx, gp, p, alpha, xNew, fNew, gNew, opts, c2);
+        if (!ok && !(fNew < fx))
+        {
+            break;  // no progress along p
+        }
+        report.iterations++;
+        x.swap(xNew);
+        g.swap(gNew);
+        fx = fNew;
+    }
+    report.value     = fx;
+    report.gradNorm  = g.norm();
+    report.converged = g.norm() <= tol;
+    return report;
+}
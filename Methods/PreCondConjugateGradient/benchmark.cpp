@@ -0,0 +1,129 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "linear_operators.hpp"
+#include "precond_conjugate_gradient.hpp"
+#include "preconditioners.hpp"
+
+using Eigen::VectorXd;
+using Eigen::VectorXf;
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+
+/// @brief Scales a matrix symmetrically, A <- D A D, which keeps it SPD but makes it badly scaled.
+/// @param A is the matrix to scale in place.
+/// @param d is the diagonal of D.
+void scaleSymmetric(CSRMatrix<float>& A, const VectorXf& d)
+{
+    for (Eigen::Index i = 0; i < A.rows(); i++)
+    {
+        for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1]; k++)
+        {
+            A.values[k] *= d[i] * d[A.colIdx[k]];
+        }
+    }
+}
+
+
+/// @brief Solves A x = b with preconditioned CG and prints setup time, iterations, solve time and the achieved
+/// relative residual. In float the recursive residual of CG drifts from the true one, by up to two orders of
+/// magnitude on the larger scaled problems, so stopping on it would compare the preconditioners at different
+/// accuracies. The float solves are therefore refined: the true residual is computed in double and the correction
+/// solved again in float until it is below the target, and the iterations of all corrections are counted.
+/// @param name is the name of the preconditioner.
+/// @param A is the system matrix.
+/// @param b is the right hand side.
+/// @param makePrec builds the preconditioner, its runtime is reported as setup time.
+template<typename MakePrec>
+void runCase(const string& name, const CSRMatrix<float>& A, const VectorXf& b, MakePrec makePrec)
+{
+    const double target         = 1e-4;
+    const u_int  maxIter        = 20000;
+    const int    maxCorrections = 10;
+
+    auto   start = high_resolution_clock::now();
+    auto   M     = makePrec();
+    double setup = duration<double>(high_resolution_clock::now() - start).count();
+
+    const CSRMatrix<double> Ad = A.cast<double>();
+    const VectorXd          bd = b.cast<double>();
+    CGWorkspace<float>      ws(b.size());
+    VectorXd                x = VectorXd::Zero(b.size()), r(b.size());
+    VectorXf                rf(b.size()), dx(b.size());
+    u_int                   iters       = 0;
+    int                     corrections = 0;
+    double                  relResidual = 1;
+    start                               = high_resolution_clock::now();
+    while (true)
+    {
+        Ad.apply(x, r);
+        r           = bd - r;
+        relResidual = r.norm() / bd.norm();
+        if (relResidual < target || corrections == maxCorrections)
+        {
+            break;
+        }
+        rf = r.cast<float>();
+        dx.setZero();
+        iters += precondConjugateGradientInPlace(M, A, rf, dx, float(target * bd.norm()), maxIter, ws);
+        x     += dx.cast<double>();
+        corrections++;
+    }
+    double solve = duration<double>(high_resolution_clock::now() - start).count();
+
+    cout << std::left << std::setw(16) << name << std::right << std::setw(12) << setup << std::setw(12) << iters
+         << std::setw(13) << corrections << std::setw(12) << solve << std::setw(14) << relResidual << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    vector<int> nxList = {64, 128, 256};
+    if (argc > 1)
+    {
+        nxList = {std::stoi(argv[1])};
+    }
+
+    cout << std::setprecision(4);
+    for (int scaled = 0; scaled < 2; scaled++)
+    {
+        for (int nx : nxList)
+        {
+            CSRMatrix<float> A = makePoisson2D<float>(nx, nx);
+            if (scaled)
+            {
+                // Row scalings in [1, 10], i.e. coefficients spanning two orders of magnitude
+                VectorXf d = (VectorXf::Random(A.rows()).array() + 1.0f) * 4.5f + 1.0f;
+                scaleSymmetric(A, d);
+            }
+            VectorXf b = VectorXf::Ones(A.rows());
+
+            cout << (scaled ? "Scaled Poisson D A D" : "Poisson") << " " << nx << "x" << nx << ", n = " << A.rows()
+                 << ", nnz = " << A.nonZeros() << endl;
+            cout << std::left << std::setw(16) << "preconditioner" << std::right << std::setw(12) << "setup (s)"
+                 << std::setw(12) << "iterations" << std::setw(13) << "corrections" << std::setw(12) << "solve (s)"
+                 << std::setw(14) << "rel. residual" << endl;
+            runCase("none", A, b, [&]() { return IdentityPreconditioner<float>(A.rows()); });
+            runCase("Jacobi", A, b, [&]() { return JacobiPreconditioner<float>(A); });
+            runCase("block-Jacobi(8)", A, b, [&]() { return BlockJacobiPreconditioner<float>(A, 8); });
+            runCase("block-Jacobi(32)", A, b, [&]() { return BlockJacobiPreconditioner<float>(A, 32); });
+            runCase("SSOR(1.0)", A, b, [&]() { return SSORPreconditioner<float>(A, 1.0f); });
+            runCase("SSOR(1.5)", A, b, [&]() { return SSORPreconditioner<float>(A, 1.5f); });
+            runCase("IC(0)", A, b, [&]() { return IncompleteCholeskyPreconditioner<float>(A); });
+            cout << endl;
+        }
+    }
+
+    return 0;
+}
@@ -1,48 +1,18 @@
+#include <cassert>
 #include <iostream>
 #include <Eigen/Dense>
 
+#include "linear_operators.hpp"
+#include "precond_conjugate_gradient.hpp"
+#include "preconditioners.hpp"
+#include "solver_telemetry.hpp"
+
 using Eigen::MatrixXf;
 using Eigen::VectorXf;
 using std::cout;
 using std::endl;
 
 
-/// @brief Computes the solution of the linear system Ax = b using the preconditioned conjugate gradient method. The matrices A and M are expected to be symmetric and positive definite (SPD).
-/// @param Minv is the inverse of the preconditioner matrix.
-/// @param A is the matrix of the linear system.
-/// @param b is the right hand side of the linear system.
-/// @param x0 is the initial guess of the solution.
-/// @param tol is the error tolerance of the method.
-/// @param maxIter is the maximum number of iterations.
-/// @return Estimation of the solution x.
-VectorXf precondConjugateGradient(const MatrixXf& Minv, const MatrixXf& A, const VectorXf& b, const VectorXf& x0, const float& tol, const u_int& maxIter)
-{
-    const float err = 1e-14 * b.norm();
-
-    VectorXf x = x0;
-    VectorXf r = b - A * x;
-    VectorXf z = Minv * r;
-    VectorXf p = z;
-
-    float alpha = 1;
-    VectorXf ri = r;
-    VectorXf zi = z;
-    uint32_t j = 0;
-    while (r.norm() > err && j < maxIter)
-    {
-        alpha = ri.dot(zi) / (p.dot(A * p));
-        x += alpha * p;
-        r -= alpha * A * p;
-        z = Minv * r;
-        p = z + (r.dot(z) / ri.dot(zi)) * p;
-        j++;
-        ri = r;
-        zi = z;
-    }
-    return x;
-}
-
-
 int main()  // int argc, char* argv[])
 {
     MatrixXf A(3, 3); 
@@ -62,7 +32,7 @@ int main()  // int argc, char* argv[])
     float tol = 1e-14 * b.norm();
     u_int maxIter = 10000;
 
-    VectorXf x = precondConjugateGradient(Minv, A, b, x0, tol, maxIter);
+    VectorXf x = precondConjugateGradient(DenseOperator<float>(Minv), DenseOperator<float>(A), b, x0, tol, maxIter);
     cout << "This is the initial vector x0 : " << endl;
     cout << x0 << endl;
     cout << "This is the found solution vector x : " << endl;
@@ -70,5 +40,32 @@ int main()  // int argc, char* argv[])
     cout << "This is the vector b : " << endl;
     cout << b << endl;
 
+    // Poisson problem -Δu = 1 with an incomplete Cholesky preconditioner, applied in O(nnz)
+    const int        nx   = 64;
+    CSRMatrix<float> Ap   = makePoisson2D<float>(nx, nx);
+    VectorXf         bp   = VectorXf::Ones(nx * nx);
+    VectorXf         xp   = VectorXf::Zero(nx * nx);
+    float            tolp = 1e-4 * bp.norm();
+
+    CGWorkspace<float> ws;
+    u_int itCG  = precondConjugateGradientInPlace(IdentityPreconditioner<float>(Ap.rows()), Ap, bp, xp, tolp, maxIter, ws);
+    xp.setZero();
+    u_int itIC0 = precondConjugateGradientInPlace(IncompleteCholeskyPreconditioner<float>(Ap), Ap, bp, xp, tolp, maxIter, ws);
+
+    VectorXf res(nx * nx);
+    Ap.apply(xp, res);
+    cout << "Poisson " << nx << "x" << nx << " : " << itCG << " iterations without preconditioner, " << itIC0 << " with IC(0)" << endl;
+    assert((bp - res).norm() < 1e-3 * bp.norm() && "IC(0) preconditioned CG did not converge");
+    assert(itIC0 < itCG && "IC(0) did not reduce the number of iterations");
+
+    // Same solve with telemetry, the preconditioner time is reported separately from the operator apply
+    SolverTelemetry telemetry("pcg_ic0");
+    xp.setZero();
+    precondConjugateGradientInPlace(IncompleteCholeskyPreconditioner<float>(Ap), Ap, bp, xp, tolp, maxIter, ws, telemetry);
+    auto tot = telemetry.totals();
+    cout << "Telemetry: apply " << tot.tApply << " s, preconditioner " << tot.tPrecond << " s, vector ops " << tot.tVector << " s" << endl;
+    telemetry.writeJSON("pcg_telemetry.json");
+    assert(u_int(telemetry.iterations()) == itIC0 && "Telemetry recorded a different number of iterations");
+
     return 0;
 }
\ No newline at end of file
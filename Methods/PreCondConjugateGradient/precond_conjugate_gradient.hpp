@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cmath>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+#include <Eigen/Dense>
+#include "cg_kernels.hpp"
+#include "linear_operators.hpp"
+#include "solver_telemetry.hpp"
+
+
+/// @brief A preconditioner applies z = M^{-1} r to vectors of the scalar type of the system. It has the same
+/// shape as a LinearOperator, so precondConjugateGradient accepts either a preconditioner of preconditioners.hpp
+/// or any explicit operator, but a float preconditioner for a double system is rejected at the call site rather
+/// than deep inside the iteration.
+/// @tparam Scalar is the scalar type of the system operator.
+template<typename P, typename Scalar>
+concept Preconditioner = LinearOperator<P> && std::same_as<typename P::Scalar, Scalar>;
+
+
+/// @brief Computes the solution of the linear system Ax = b in place using the preconditioned conjugate gradient method. The operators A and Minv are expected to be symmetric and positive definite (SPD).
+/// All vectors live in the workspace, so the iteration does not allocate, and A * p is computed once per iteration.
+/// @param Minv is the inverse of the preconditioner, applied as z = Minv * r (see Preconditioner).
+/// @param A is the linear operator of the system (see LinearOperator).
+/// @param b is the right hand side of the linear system.
+/// @param x is the initial guess on entry and the estimation of the solution on exit.
+/// @param tol is the error tolerance of the method.
+/// @param maxIter is the maximum number of iterations.
+/// @param ws is the workspace, resized to b.size() if needed.
+/// @param telemetry is the instrumentation hook (see SolverTelemetry), NoTelemetry records nothing and costs nothing.
+/// @return The number of iterations performed.
+template<LinearOperator Op, Preconditioner<typename Op::Scalar> Prec, typename Telemetry = NoTelemetry>
+u_int precondConjugateGradientInPlace(const Prec&                                                  Minv,
+                                      const Op&                                                    A,
+                                      const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& b,
+                                      Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>&       x,
+                                      const typename Op::Scalar&                                   tol,
+                                      const u_int&                                                 maxIter,
+                                      CGWorkspace<typename Op::Scalar>&                            ws,
+                                      Telemetry&&                                                  telemetry = Telemetry())
+{
+    using Scalar = typename Op::Scalar;
+
+    ws.resize(b.size());
+    auto& r = ws.r;
+    auto& z = ws.z;
+    auto& p = ws.p;
+    auto& w = ws.w;
+
+    // bytes per iteration besides the applies: p.dot(w) plus the fused update (read 6, write 2), r.dot(z) plus the direction update (read 4, write 1)
+    constexpr bool enabled     = std::remove_cvref_t<Telemetry>::enabled;
+    const double   applyBytes  = enabled ? bytesPerApply(A) : 0.0;
+    const double   precBytes   = enabled ? bytesPerApply(Minv) : 0.0;
+    const double   updateBytes = 8.0 * b.size() * sizeof(Scalar);
+    const double   vectorBytes = 5.0 * b.size() * sizeof(Scalar);
+
+    telemetry.begin(b.size());
+    auto t = telemetry.now();
+    A.apply(x, w);
+    telemetry.record(SolverPhase::Apply, t, applyBytes);
+    r = b - w;
+    t = telemetry.now();
+    Minv.apply(r, z);
+    telemetry.record(SolverPhase::Precond, t, precBytes);
+    p = z;
+
+    Scalar   alpha, beta;
+    Scalar   rr = r.squaredNorm();
+    Scalar   rz = r.dot(z);
+    Scalar   rzNew;
+    uint32_t j = 0;
+    telemetry.endIteration(std::sqrt(rr));
+    while (std::sqrt(rr) > tol && j < maxIter)
+    {
+        t = telemetry.now();
+        A.apply(p, w);
+        telemetry.record(SolverPhase::Apply, t, applyBytes);
+        t     = telemetry.now();
+        alpha = rz / parallelDot(p, w);
+        rr    = fusedUpdateSolutionResidual(x, r, p, w, alpha);
+        telemetry.record(SolverPhase::Vector, t, updateBytes);
+        t = telemetry.now();
+        Minv.apply(r, z);
+        telemetry.record(SolverPhase::Precond, t, precBytes);
+        t     = telemetry.now();
+        rzNew = parallelDot(r, z);
+        beta  = rzNew / rz;
+        updateDirection(p, z, beta);
+        telemetry.record(SolverPhase::Vector, t, vectorBytes);
+        telemetry.endIteration(std::sqrt(rr));
+        rz = rzNew;
+        j++;
+    }
+    return j;
+}
+
+
+/// @brief Computes the solution of the linear system Ax = b using the preconditioned conjugate gradient method. The operators A and Minv are expected to be symmetric and positive definite (SPD).
+/// @param Minv is the inverse of the preconditioner, applied as z = Minv * r (see Preconditioner).
+/// @param A is the linear operator of the system (see LinearOperator).
+/// @param b is the right hand side of the linear system.
+/// @param x0 is the initial guess of the solution.
+/// @param tol is the error tolerance of the method.
+/// @param maxIter is the maximum number of iterations.
+/// @param telemetry is the instrumentation hook (see SolverTelemetry), NoTelemetry records nothing and costs nothing.
+/// @return Estimation of the solution x.
+template<LinearOperator Op, Preconditioner<typename Op::Scalar> Prec, typename Telemetry = NoTelemetry>
+Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1> precondConjugateGradient(const Prec&                                                  Minv,
+                                                                               const Op&                                                    A,
+                                                                               const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& b,
+                                                                               const Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1>& x0,
+                                                                               const typename Op::Scalar&                                   tol,
+                                                                               const u_int&                                                 maxIter,
+                                                                               Telemetry&&                                                  telemetry = Telemetry())
+{
+    CGWorkspace<typename Op::Scalar>                      ws(b.size());
+    Eigen::Matrix<typename Op::Scalar, Eigen::Dynamic, 1> x = x0;
+    precondConjugateGradientInPlace(Minv, A, b, x, tol, maxIter, ws, std::forward<Telemetry>(telemetry));
+    return x;
+}
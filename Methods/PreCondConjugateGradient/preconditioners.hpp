@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+#include "linear_operators.hpp"
+
+
+// Preconditioners for precondConjugateGradient: each applies z = M^{-1} r with the interface of a LinearOperator,
+// so it satisfies the Preconditioner concept of precond_conjugate_gradient.hpp.
+
+
+/// @brief Trivial preconditioner M = I, i.e. plain conjugate gradient.
+/// @tparam T is the scalar type.
+template<typename T>
+struct IdentityPreconditioner
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Eigen::Index n;
+
+    explicit IdentityPreconditioner(Eigen::Index n)
+    : n(n)
+    {
+    }
+
+    Eigen::Index rows() const { return n; }
+    Eigen::Index cols() const { return n; }
+
+    void apply(const Vector& r, Vector& z) const { z = r; }
+};
+
+
+/// @brief Jacobi preconditioner M = diag(A). O(n) per apply.
+/// @tparam T is the scalar type.
+template<typename T>
+struct JacobiPreconditioner
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    Vector invDiag;
+
+    /// @brief Constructor
+    /// @param A is the SPD system matrix.
+    explicit JacobiPreconditioner(const CSRMatrix<T>& A)
+    : invDiag(Vector::Zero(A.rows()))
+    {
+        for (Eigen::Index i = 0; i < A.rows(); i++)
+        {
+            for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1]; k++)
+            {
+                if (A.colIdx[k] == i)
+                {
+                    invDiag[i] = 1 / A.values[k];
+                }
+            }
+            assert(invDiag[i] > 0 && "Jacobi preconditioner needs a positive diagonal");
+        }
+    }
+
+    Eigen::Index rows() const { return invDiag.size(); }
+    Eigen::Index cols() const { return invDiag.size(); }
+
+    void apply(const Vector& r, Vector& z) const { z = invDiag.cwiseProduct(r); }
+};
+
+
+/// @brief Block-Jacobi preconditioner: M is the block diagonal of A with contiguous (bs, bs) blocks.
+/// Each block is inverted once through its Cholesky decomposition, so applying M^{-1} is one small
+/// dense matrix-vector product per block, O(n * bs) per apply.
+/// @tparam T is the scalar type.
+template<typename T>
+struct BlockJacobiPreconditioner
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+    Eigen::Index n;
+    Eigen::Index blockSize;
+    Matrix       invBlocks;  // (bs, n), the inverse of block b is stored in columns [b * bs, (b + 1) * bs)
+
+    /// @brief Constructor
+    /// @param A is the SPD system matrix.
+    /// @param blockSize is the size of the diagonal blocks, the last block may be smaller.
+    BlockJacobiPreconditioner(const CSRMatrix<T>& A, Eigen::Index blockSize)
+    : n(A.rows())
+    , blockSize(blockSize)
+    , invBlocks(Matrix::Zero(blockSize, A.rows()))
+    {
+        assert(blockSize > 0 && "Block size must be positive");
+        for (Eigen::Index start = 0; start < n; start += blockSize)
+        {
+            const Eigen::Index len = std::min(blockSize, n - start);
+            Matrix             D   = Matrix::Zero(len, len);
+            for (Eigen::Index i = start; i < start + len; i++)
+            {
+                for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1]; k++)
+                {
+                    const Eigen::Index j = A.colIdx[k];
+                    if (j >= start && j < start + len)
+                    {
+                        D(i - start, j - start) = A.values[k];
+                    }
+                }
+            }
+            Eigen::LLT<Matrix> llt(D);
+            assert(llt.info() == Eigen::Success && "Diagonal block is not SPD");
+            invBlocks.block(0, start, len, len) = llt.solve(Matrix::Identity(len, len));
+        }
+    }
+
+    Eigen::Index rows() const { return n; }
+    Eigen::Index cols() const { return n; }
+
+    void apply(const Vector& r, Vector& z) const
+    {
+        z.resize(n);
+        for (Eigen::Index start = 0; start < n; start += blockSize)
+        {
+            const Eigen::Index len          = std::min(blockSize, n - start);
+            z.segment(start, len).noalias() = invBlocks.block(0, start, len, len) * r.segment(start, len);
+        }
+    }
+};
+
+
+/// @brief Symmetric successive over-relaxation (SSOR) preconditioner
+/// M = omega / (2 - omega) * (D / omega + L) (D / omega)^{-1} (D / omega + U), with A = L + D + U.
+/// Applied by one forward and one backward sweep over A, O(nnz) per apply.
+/// @tparam T is the scalar type.
+template<typename T>
+struct SSORPreconditioner
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    const CSRMatrix<T>& A;
+    T                   omega;
+    Vector              diag;
+
+    /// @brief Constructor
+    /// @param A is the SPD system matrix, it must outlive the preconditioner.
+    /// @param omega is the relaxation parameter in (0, 2), omega = 1 gives symmetric Gauss-Seidel.
+    SSORPreconditioner(const CSRMatrix<T>& A, T omega = 1)
+    : A(A)
+    , omega(omega)
+    , diag(Vector::Zero(A.rows()))
+    {
+        assert(omega > 0 && omega < 2 && "SSOR needs 0 < omega < 2");
+        for (Eigen::Index i = 0; i < A.rows(); i++)
+        {
+            for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1]; k++)
+            {
+                if (A.colIdx[k] == i)
+                {
+                    diag[i] = A.values[k];
+                }
+            }
+            assert(diag[i] > 0 && "SSOR preconditioner needs a positive diagonal");
+        }
+    }
+
+    /// @brief Only a reference to A is kept, so a temporary matrix would dangle.
+    SSORPreconditioner(CSRMatrix<T>&& A, T omega = 1) = delete;
+
+    Eigen::Index rows() const { return A.rows(); }
+    Eigen::Index cols() const { return A.cols(); }
+
+    void apply(const Vector& r, Vector& z) const
+    {
+        const Eigen::Index n = A.rows();
+        z.resize(n);
+        // Forward sweep: (D / omega + L) y = r
+        for (Eigen::Index i = 0; i < n; i++)
+        {
+            T sum = r[i];
+            for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1] && A.colIdx[k] < i; k++)
+            {
+                sum -= A.values[k] * z[A.colIdx[k]];
+            }
+            z[i] = sum * omega / diag[i];
+        }
+        // Scaling by D / omega and by (2 - omega) / omega in one step
+        const T scale = (2 - omega) / (omega * omega);
+        z             = scale * diag.cwiseProduct(z);
+        // Backward sweep: (D / omega + U) z = y
+        for (Eigen::Index i = n - 1; i >= 0; i--)
+        {
+            T sum = z[i];
+            for (Eigen::Index k = A.rowPtr[i + 1] - 1; k >= A.rowPtr[i] && A.colIdx[k] > i; k--)
+            {
+                sum -= A.values[k] * z[A.colIdx[k]];
+            }
+            z[i] = sum * omega / diag[i];
+        }
+    }
+};
+
+
+/// @brief Incomplete Cholesky preconditioner without fill-in, IC(0): A ~ L L^T where L has the
+/// sparsity pattern of the lower triangle of A. Applied by two triangular sweeps, O(nnz) per apply.
+/// The column indices of every row of A are expected to be sorted.
+/// @tparam T is the scalar type.
+template<typename T>
+struct IncompleteCholeskyPreconditioner
+{
+    using Scalar = T;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+    CSRMatrix<T> L;  // lower triangular factor, the diagonal is the last entry of each row
+
+    /// @brief Constructor, computes the IC(0) factorization.
+    /// @param A is the SPD system matrix.
+    explicit IncompleteCholeskyPreconditioner(const CSRMatrix<T>& A)
+    {
+        const Eigen::Index n = A.rows();
+        L.nRows              = n;
+        L.nCols              = n;
+        L.rowPtr.assign(1, 0);
+        for (Eigen::Index i = 0; i < n; i++)
+        {
+            for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1] && A.colIdx[k] <= i; k++)
+            {
+                L.colIdx.push_back(A.colIdx[k]);
+                L.values.push_back(A.values[k]);
+            }
+            assert(L.colIdx.back() == i && "IC(0) needs a stored diagonal entry in every row");
+            L.rowPtr.push_back(static_cast<Eigen::Index>(L.values.size()));
+        }
+
+        // Row-wise factorization: L_ij = (A_ij - sum_{k<j} L_ik L_jk) / L_jj restricted to the pattern
+        for (Eigen::Index i = 0; i < n; i++)
+        {
+            const Eigen::Index rowEnd = L.rowPtr[i + 1] - 1;  // position of L_ii
+            for (Eigen::Index a = L.rowPtr[i]; a < rowEnd; a++)
+            {
+                const int j = L.colIdx[a];
+                // Sparse dot product of rows i and j over columns < j, both sorted
+                T            sum = 0;
+                Eigen::Index p   = L.rowPtr[i];
+                Eigen::Index q   = L.rowPtr[j];
+                while (p < a && q < L.rowPtr[j + 1] - 1)
+                {
+                    if (L.colIdx[p] == L.colIdx[q])
+                        sum += L.values[p++] * L.values[q++];
+                    else if (L.colIdx[p] < L.colIdx[q])
+                        p++;
+                    else
+                        q++;
+                }
+                L.values[a] = (L.values[a] - sum) / L.values[L.rowPtr[j + 1] - 1];
+            }
+            T diag = L.values[rowEnd];
+            for (Eigen::Index a = L.rowPtr[i]; a < rowEnd; a++)
+            {
+                diag -= L.values[a] * L.values[a];
+            }
+            assert(diag > 0 && "IC(0) breakdown: non-positive pivot");
+            L.values[rowEnd] = std::sqrt(diag);
+        }
+    }
+
+    Eigen::Index rows() const { return L.rows(); }
+    Eigen::Index cols() const { return L.cols(); }
+
+    void apply(const Vector& r, Vector& z) const
+    {
+        const Eigen::Index n = L.rows();
+        z                    = r;
+        // Forward sweep: L y = r
+        for (Eigen::Index i = 0; i < n; i++)
+        {
+            const Eigen::Index rowEnd = L.rowPtr[i + 1] - 1;
+            T                  sum    = z[i];
+            for (Eigen::Index k = L.rowPtr[i]; k < rowEnd; k++)
+            {
+                sum -= L.values[k] * z[L.colIdx[k]];
+            }
+            z[i] = sum / L.values[rowEnd];
+        }
+        // Backward sweep: L^T z = y, column-oriented over the rows of L
+        for (Eigen::Index i = n - 1; i >= 0; i--)
+        {
+            const Eigen::Index rowEnd = L.rowPtr[i + 1] - 1;
+            z[i] /= L.values[rowEnd];
+            for (Eigen::Index k = L.rowPtr[i]; k < rowEnd; k++)
+            {
+                z[L.colIdx[k]] -= L.values[k] * z[i];
+            }
+        }
+    }
+};
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <Eigen/Sparse>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "conjugate_gradient.hpp"
+#include "linear_operators.hpp"
+#include "precond_conjugate_gradient.hpp"
+#include "preconditioners.hpp"
+#include "sell_matrix.hpp"
+
+using Eigen::VectorXf;
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+
+/// @brief Measures the median runtime of a function after one warmup run.
+/// @param func is the function to be measured.
+/// @param reps is the number of timed repetitions.
+/// @return The median runtime in seconds.
+double medianRunTime(const function<void(void)>& func, int reps = 20)
+{
+    func();
+    vector<double> times(reps);
+    for (double& t : times)
+    {
+        auto start = high_resolution_clock::now();
+        func();
+        t = duration<double>(high_resolution_clock::now() - start).count();
+    }
+    std::nth_element(times.begin(), times.begin() + reps / 2, times.end());
+    return times[reps / 2];
+}
+
+
+/// @brief Builds an (n, n) matrix with very uneven row lengths: lengths follow a power law between
+/// 1 and maxLen, columns are drawn uniformly. Not symmetric, only meant for SpMV timings.
+CSRMatrix<float> makeIrregular(int n, int maxLen, unsigned seed = 42)
+{
+    std::mt19937                          gen(seed);
+    std::uniform_real_distribution<float> unif(0, 1);
+    std::uniform_int_distribution<int>    col(0, n - 1);
+    vector<Eigen::Triplet<float>>         triplets;
+    for (int i = 0; i < n; i++)
+    {
+        const int len = std::min(maxLen, int(std::pow(float(maxLen), unif(gen) * unif(gen))));
+        triplets.emplace_back(i, i, 4.0f);
+        for (int k = 1; k < len; k++)
+        {
+            triplets.emplace_back(i, col(gen), -unif(gen));
+        }
+    }
+    return CSRMatrix<float>::fromTriplets(n, n, triplets);
+}
+
+
+/// @brief Prints one line of the benchmark table.
+/// @param name is the format name.
+/// @param t is the median time of one SpMV in seconds.
+/// @param nnz is the number of nonzeros, each contributing 2 flops.
+/// @param bytes is the number of bytes moved by one SpMV (matrix arrays plus x and y once).
+void report(const string& name, double t, Eigen::Index nnz, double bytes)
+{
+    cout << std::left << std::setw(22) << name << std::right << std::setw(12) << t * 1e3 << std::setw(12)
+         << 2.0 * nnz / t * 1e-9 << std::setw(12) << bytes / t * 1e-9 << endl;
+}
+
+
+/// @brief Times y = A x for Eigen's SparseMatrix and for the CSR and SELL-C-sigma operators.
+void benchmark(const string& name, const CSRMatrix<float>& A)
+{
+    const Eigen::Index n   = A.rows();
+    const Eigen::Index nnz = A.nonZeros();
+    const double       xy  = double(A.cols() + A.rows()) * sizeof(float);
+
+    Eigen::SparseMatrix<float, Eigen::RowMajor, int> E(n, A.cols());
+    {
+        vector<Eigen::Triplet<float>> t;
+        t.reserve(nnz);
+        for (Eigen::Index i = 0; i < n; i++)
+            for (Eigen::Index k = A.rowPtr[i]; k < A.rowPtr[i + 1]; k++)
+                t.emplace_back(i, A.colIdx[k], A.values[k]);
+        E.setFromTriplets(t.begin(), t.end());
+    }
+    SELLMatrix<float, 8>  S8(A);
+    SELLMatrix<float, 8>  S8unsorted(A, 1);
+    SELLMatrix<float, 16> S16(A);
+
+    VectorXf x = VectorXf::Random(A.cols());
+    VectorXf y(n), yRef(n);
+    yRef = E * x;
+
+    cout << name << ": n = " << n << ", nnz = " << nnz << ", padding SELL-8-1 " << S8unsorted.paddingRatio()
+         << ", SELL-8-" << S8.sigma << " " << S8.paddingRatio() << endl;
+    cout << std::left << std::setw(22) << "format" << std::right << std::setw(12) << "time (ms)" << std::setw(12)
+         << "GFLOP/s" << std::setw(12) << "GB/s" << endl;
+
+    double csrBytes = double(nnz) * (sizeof(float) + sizeof(int)) + double(n + 1) * sizeof(Eigen::Index) + xy;
+    report("Eigen SparseMatrix", medianRunTime([&]() { y.noalias() = E * x; }), nnz,
+           double(nnz) * (sizeof(float) + sizeof(int)) + double(n + 1) * sizeof(int) + xy);
+    report("CSR", medianRunTime([&]() { A.apply(x, y); }), nnz, csrBytes);
+    assert(y.isApprox(yRef, 1e-4) && "CSR SpMV is wrong");
+
+    auto sellBytes = [&](const auto& S) {
+        return double(S.values.size()) * (sizeof(float) + sizeof(int)) + double(S.chunkLen.size()) * (sizeof(Eigen::Index) + sizeof(int))
+             + double(n) * sizeof(int) + xy;
+    };
+    report("SELL-8-1", medianRunTime([&]() { S8unsorted.apply(x, y); }), nnz, sellBytes(S8unsorted));
+    assert(y.isApprox(yRef, 1e-4) && "SELL-8-1 SpMV is wrong");
+    report("SELL-8-" + std::to_string(S8.sigma), medianRunTime([&]() { S8.apply(x, y); }), nnz, sellBytes(S8));
+    assert(y.isApprox(yRef, 1e-4) && "SELL-8-sigma SpMV is wrong");
+    report("SELL-16-" + std::to_string(S16.sigma), medianRunTime([&]() { S16.apply(x, y); }), nnz, sellBytes(S16));
+    assert(y.isApprox(yRef, 1e-4) && "SELL-16-sigma SpMV is wrong");
+    cout << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const int nx = argc > 1 ? std::stoi(argv[1]) : 1024;
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl << endl;
+#endif
+
+    CSRMatrix<float> poisson = makePoisson2D<float>(nx, nx);
+    benchmark("Poisson 2D " + std::to_string(nx) + "x" + std::to_string(nx), poisson);
+    benchmark("Irregular power-law rows", makeIrregular(nx * nx, 200));
+
+    // The SELL-C-sigma operator plugs into both CG solvers as any other LinearOperator
+    const int            n = 128 * 128;
+    CSRMatrix<float>     A = makePoisson2D<float>(128, 128);
+    SELLMatrix<float, 8> S(A);
+    VectorXf             b  = VectorXf::Ones(n);
+    VectorXf             x0 = VectorXf::Zero(n);
+    VectorXf             r(n);
+
+    VectorXf x = conjugateGradient(S, b, x0, 1e-3f * b.norm(), 10000);
+    A.apply(x, r);
+    cout << "CG with SELL-8-" << S.sigma << " : relative residual " << (b - r).norm() / b.norm() << endl;
+    assert((b - r).norm() < 1e-2 * b.norm() && "CG with SELL-C-sigma did not converge");
+
+    x = precondConjugateGradient(JacobiPreconditioner<float>(A), S, b, x0, 1e-3f * b.norm(), 10000u);
+    A.apply(x, r);
+    cout << "PCG with SELL-8-" << S.sigma << " : relative residual " << (b - r).norm() / b.norm() << endl;
+    assert((b - r).norm() < 1e-2 * b.norm() && "PCG with SELL-C-sigma did not converge");
+
+    return 0;
+}
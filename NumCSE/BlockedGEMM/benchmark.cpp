@@ -0,0 +1,56 @@
+#include <iomanip>
+#include <iostream>
+#include <Eigen/Dense>
+
+#include "benchmark_stats.hpp"
+#include "gemm.hpp"
+
+using Eigen::MatrixXd;
+using Eigen::MatrixXf;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Prints the GFLOP/s of Eigen's GEMM and of the blocked GEMM for C (m, n) = A (m, k) * B (k, n), from the
+/// fastest run under the default repetition policy of measure.
+template<typename Matrix>
+void benchmark(const char* type, Eigen::Index m, Eigen::Index k, Eigen::Index n)
+{
+    using T = typename Matrix::Scalar;
+
+    GemmWorkspace<T> ws;
+    Matrix           A = Matrix::Random(m, k), B = Matrix::Random(k, n), C(m, n), D(m, n);
+    const double     flops  = 2.0 * m * n * k;
+    const double     tEigen = measure([&] { D.noalias() = A * B; }).min;
+    const double     tOwn   = measure([&] { gemm(A, B, C, ws); }).min;
+    cout << setw(8) << type << setw(8) << m << setw(8) << k << setw(8) << n << setw(14) << flops / tEigen * 1e-9
+         << setw(14) << flops / tOwn * 1e-9 << setw(12) << (C - D).norm() / D.norm() << endl;
+}
+
+
+int main()
+{
+    cout << "Micro-tile " << GemmBlocking<float>::MR << "x" << GemmBlocking<float>::NR << ", KC " << GemmBlocking<float>::KC
+         << ", MC " << GemmBlocking<float>::MC << ", NC " << GemmBlocking<float>::NC << " (float)" << endl;
+    cout << setw(8) << "type" << setw(8) << "m" << setw(8) << "k" << setw(8) << "n" << setw(14) << "Eigen GF/s"
+         << setw(14) << "blocked GF/s" << setw(12) << "rel. error" << endl;
+
+    // square
+    for (int N : {128, 256, 512, 1024, 2048})
+    {
+        benchmark<MatrixXf>("float", N, N, N);
+    }
+    for (int N : {256, 1024})
+    {
+        benchmark<MatrixXd>("double", N, N, N);
+    }
+    // tall-skinny: block Krylov and QR shapes, and Strassen leaves
+    benchmark<MatrixXf>("float", 100000, 16, 16);
+    benchmark<MatrixXf>("float", 100000, 64, 64);
+    benchmark<MatrixXf>("float", 16, 100000, 16);
+    benchmark<MatrixXf>("float", 4096, 256, 64);
+    benchmark<MatrixXd>("double", 100000, 32, 32);
+
+    return 0;
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include <Eigen/Dense>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+/// @brief SIMD operations used by the micro-kernel, selected at compile time from the target flags
+/// (AVX-512, AVX2 with FMA, SSE2, NEON, or a portable fallback). Vec holds `width` values of T.
+template<typename T>
+struct SimdOps;
+
+#if defined(__AVX512F__)
+template<>
+struct SimdOps<float>
+{
+    using Vec                 = __m512;
+    static constexpr int width = 16;
+    static Vec  zero() { return _mm512_setzero_ps(); }
+    static Vec  load(const float* p) { return _mm512_loadu_ps(p); }
+    static Vec  broadcast(float x) { return _mm512_set1_ps(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static void store(float* p, Vec a) { _mm512_storeu_ps(p, a); }
+};
+template<>
+struct SimdOps<double>
+{
+    using Vec                 = __m512d;
+    static constexpr int width = 8;
+    static Vec  zero() { return _mm512_setzero_pd(); }
+    static Vec  load(const double* p) { return _mm512_loadu_pd(p); }
+    static Vec  broadcast(double x) { return _mm512_set1_pd(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a, b, c); }
+    static void store(double* p, Vec a) { _mm512_storeu_pd(p, a); }
+};
+#elif defined(__AVX2__) && defined(__FMA__)
+template<>
+struct SimdOps<float>
+{
+    using Vec                 = __m256;
+    static constexpr int width = 8;
+    static Vec  zero() { return _mm256_setzero_ps(); }
+    static Vec  load(const float* p) { return _mm256_loadu_ps(p); }
+    static Vec  broadcast(float x) { return _mm256_set1_ps(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+    static void store(float* p, Vec a) { _mm256_storeu_ps(p, a); }
+};
+template<>
+struct SimdOps<double>
+{
+    using Vec                 = __m256d;
+    static constexpr int width = 4;
+    static Vec  zero() { return _mm256_setzero_pd(); }
+    static Vec  load(const double* p) { return _mm256_loadu_pd(p); }
+    static Vec  broadcast(double x) { return _mm256_set1_pd(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a, b, c); }
+    static void store(double* p, Vec a) { _mm256_storeu_pd(p, a); }
+};
+#elif defined(__SSE2__)
+template<>
+struct SimdOps<float>
+{
+    using Vec                 = __m128;
+    static constexpr int width = 4;
+    static Vec  zero() { return _mm_setzero_ps(); }
+    static Vec  load(const float* p) { return _mm_loadu_ps(p); }
+    static Vec  broadcast(float x) { return _mm_set1_ps(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static void store(float* p, Vec a) { _mm_storeu_ps(p, a); }
+};
+template<>
+struct SimdOps<double>
+{
+    using Vec                 = __m128d;
+    static constexpr int width = 2;
+    static Vec  zero() { return _mm_setzero_pd(); }
+    static Vec  load(const double* p) { return _mm_loadu_pd(p); }
+    static Vec  broadcast(double x) { return _mm_set1_pd(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static void store(double* p, Vec a) { _mm_storeu_pd(p, a); }
+};
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+template<>
+struct SimdOps<float>
+{
+    using Vec                 = float32x4_t;
+    static constexpr int width = 4;
+    static Vec  zero() { return vdupq_n_f32(0.0f); }
+    static Vec  load(const float* p) { return vld1q_f32(p); }
+    static Vec  broadcast(float x) { return vdupq_n_f32(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return vfmaq_f32(c, a, b); }
+    static void store(float* p, Vec a) { vst1q_f32(p, a); }
+};
+template<>
+struct SimdOps<double>
+{
+    using Vec                 = float64x2_t;
+    static constexpr int width = 2;
+    static Vec  zero() { return vdupq_n_f64(0.0); }
+    static Vec  load(const double* p) { return vld1q_f64(p); }
+    static Vec  broadcast(double x) { return vdupq_n_f64(x); }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return vfmaq_f64(c, a, b); }
+    static void store(double* p, Vec a) { vst1q_f64(p, a); }
+};
+#endif
+
+/// @brief Portable fallback for targets and scalar types without intrinsics.
+template<typename T>
+struct SimdOps
+{
+    static constexpr int width = 1;
+    using Vec                  = T;
+    static Vec  zero() { return T(0); }
+    static Vec  load(const T* p) { return *p; }
+    static Vec  broadcast(T x) { return x; }
+    static Vec  fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static void store(T* p, Vec a) { *p = a; }
+};
+
+
+/// @brief Register and cache blocking of the GEMM for a scalar type.
+/// The micro-tile is MR x NR with MR two SIMD vectors tall, so the 2 * NR accumulators, two A vectors and one
+/// broadcast of B fit in 16 registers. KC sizes a packed A micro-panel plus a packed B micro-panel for L1, MC a
+/// packed A block (MC x KC) for L2, and NC a packed B panel (KC x NC) for L3.
+template<typename T>
+struct GemmBlocking
+{
+    static constexpr Eigen::Index MR = SimdOps<T>::width > 1 ? 2 * SimdOps<T>::width : 4;
+    static constexpr Eigen::Index NR = 6;
+    static constexpr Eigen::Index KC = 1024 / sizeof(T);                          // 256 floats, 128 doubles
+    static constexpr Eigen::Index MC = (262144 / (KC * sizeof(T))) / MR * MR;   // A block of about 256 KiB
+    static constexpr Eigen::Index NC = (4194304 / (KC * sizeof(T))) / NR * NR;  // B panel of about 4 MiB
+};
+
+
+/// @brief Packing buffers of the GEMM, reused across calls so the kernel does not allocate.
+template<typename T>
+struct GemmWorkspace
+{
+    std::vector<T, Eigen::aligned_allocator<T>> packedA = std::vector<T, Eigen::aligned_allocator<T>>(GemmBlocking<T>::MC * GemmBlocking<T>::KC);
+    std::vector<T, Eigen::aligned_allocator<T>> packedB = std::vector<T, Eigen::aligned_allocator<T>>(GemmBlocking<T>::KC * GemmBlocking<T>::NC);
+};
+
+
+namespace detail
+{
+
+/// @brief Packs an (mc, kc) block of the column-major A into MR-row micro-panels, each stored k-major with the
+/// MR values of one column contiguous. Rows beyond mc are zero, so the micro-kernel never branches on the edge.
+template<typename T>
+void packA(Eigen::Index mc, Eigen::Index kc, const T* A, Eigen::Index lda, T* packed)
+{
+    constexpr Eigen::Index MR = GemmBlocking<T>::MR;
+    for (Eigen::Index i0 = 0; i0 < mc; i0 += MR)
+    {
+        const Eigen::Index mr = std::min(MR, mc - i0);
+        for (Eigen::Index p = 0; p < kc; p++)
+        {
+            std::copy_n(A + i0 + p * lda, mr, packed);
+            std::fill(packed + mr, packed + MR, T(0));
+            packed += MR;
+        }
+    }
+}
+
+/// @brief Packs a (kc, nc) block of the column-major B into NR-column micro-panels, each stored k-major with the
+/// NR values of one row contiguous. Columns beyond nc are zero.
+template<typename T>
+void packB(Eigen::Index kc, Eigen::Index nc, const T* B, Eigen::Index ldb, T* packed)
+{
+    constexpr Eigen::Index NR = GemmBlocking<T>::NR;
+    for (Eigen::Index j0 = 0; j0 < nc; j0 += NR)
+    {
+        const Eigen::Index nr = std::min(NR, nc - j0);
+        const T*           b  = B + j0 * ldb;
+        if (nr == NR)
+        {
+            // NR contiguous column streams, one row of the panel per step
+            for (Eigen::Index p = 0; p < kc; p++)
+            {
+                #pragma GCC unroll 8
+                for (Eigen::Index j = 0; j < NR; j++)
+                {
+                    packed[p * NR + j] = b[p + j * ldb];
+                }
+            }
+        }
+        else
+        {
+            for (Eigen::Index p = 0; p < kc; p++)
+            {
+                for (Eigen::Index j = 0; j < NR; j++)
+                {
+                    packed[p * NR + j] = j < nr ? b[p + j * ldb] : T(0);
+                }
+            }
+        }
+        packed += NR * kc;
+    }
+}
+
+/// @brief Micro-kernel: C(VR * W, NR) = alpha * A(VR * W, kc) * B(kc, NR) + beta * C from packed micro-panels, with
+/// the whole tile of C held in registers across the kc loop. VR is the number of SIMD vectors per column of the tile:
+/// MR / W for full tiles, fewer for the bottom edge so short blocks do not pay for the padding rows.
+template<int VR, typename T>
+void microKernel(Eigen::Index kc, const T* a, const T* b, T* C, Eigen::Index ldc, T alpha, T beta)
+{
+    using S                   = SimdOps<T>;
+    using Vec                 = typename S::Vec;
+    constexpr int          W  = S::width;
+    constexpr Eigen::Index MR = GemmBlocking<T>::MR;
+    constexpr Eigen::Index NR = GemmBlocking<T>::NR;
+
+    Vec acc[NR][VR];
+    #pragma GCC unroll 16
+    for (int j = 0; j < NR; j++)
+    {
+        #pragma GCC unroll 16
+        for (int v = 0; v < VR; v++)
+        {
+            acc[j][v] = S::zero();
+        }
+    }
+    for (Eigen::Index p = 0; p < kc; p++)
+    {
+        Vec av[VR];
+        #pragma GCC unroll 16
+        for (int v = 0; v < VR; v++)
+        {
+            av[v] = S::load(a + v * W);
+        }
+        #pragma GCC unroll 16
+        for (int j = 0; j < NR; j++)
+        {
+            const Vec bj = S::broadcast(b[j]);
+            #pragma GCC unroll 16
+            for (int v = 0; v < VR; v++)
+            {
+                acc[j][v] = S::fmadd(av[v], bj, acc[j][v]);
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+    // beta == 0 must not read C, which may be uninitialized
+    const Vec va = S::broadcast(alpha);
+    const Vec vb = S::broadcast(beta);
+    #pragma GCC unroll 16
+    for (int j = 0; j < NR; j++)
+    {
+        #pragma GCC unroll 16
+        for (int v = 0; v < VR; v++)
+        {
+            T*        c = C + j * ldc + v * W;
+            const Vec r = beta == T(0) ? S::fmadd(acc[j][v], va, S::zero()) : S::fmadd(acc[j][v], va, S::fmadd(S::load(c), vb, S::zero()));
+            S::store(c, r);
+        }
+    }
+}
+
+}  // namespace detail
+
+
+/// @brief Computes C = alpha * A * B + beta * C for column-major A (m, k), B (k, n) and C (m, n) given by pointer
+/// and leading dimension, the BLAS gemm without transposes. Goto-style: B is packed in (KC, NC) panels, A in (MC, KC)
+/// blocks, and the SIMD micro-kernel runs over MR x NR tiles of C; edge tiles go through a small buffer. beta is
+/// applied by the micro-kernels of the first KC block, so C is not swept separately.
+/// @param m, n, k are the sizes of the product.
+/// @param ws holds the packing buffers.
+template<typename T>
+void gemm(Eigen::Index m, Eigen::Index n, Eigen::Index k,
+          T alpha, const T* A, Eigen::Index lda, const T* B, Eigen::Index ldb,
+          T beta, T* C, Eigen::Index ldc, GemmWorkspace<T>& ws)
+{
+    using Blk = GemmBlocking<T>;
+
+    if (k == 0 || alpha == T(0))
+    {
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>> c(C + j * ldc, m);
+            c = beta == T(0) ? Eigen::Matrix<T, Eigen::Dynamic, 1>::Zero(m) : Eigen::Matrix<T, Eigen::Dynamic, 1>(beta * c);
+        }
+        return;
+    }
+    constexpr int W = SimdOps<T>::width;
+
+    alignas(64) T edge[Blk::MR * Blk::NR];
+    T*            pa = ws.packedA.data();
+    T*            pb = ws.packedB.data();
+    for (Eigen::Index jc = 0; jc < n; jc += Blk::NC)
+    {
+        const Eigen::Index nc = std::min(Blk::NC, n - jc);
+        for (Eigen::Index pc = 0; pc < k; pc += Blk::KC)
+        {
+            const Eigen::Index kc = std::min(Blk::KC, k - pc);
+            const T            bk = pc == 0 ? beta : T(1);
+            detail::packB(kc, nc, B + pc + jc * ldb, ldb, pb);
+            for (Eigen::Index ic = 0; ic < m; ic += Blk::MC)
+            {
+                const Eigen::Index mc = std::min(Blk::MC, m - ic);
+                detail::packA(mc, kc, A + ic + pc * lda, lda, pa);
+                for (Eigen::Index jr = 0; jr < nc; jr += Blk::NR)
+                {
+                    const Eigen::Index nr = std::min(Blk::NR, nc - jr);
+                    for (Eigen::Index ir = 0; ir < mc; ir += Blk::MR)
+                    {
+                        const Eigen::Index mr = std::min(Blk::MR, mc - ir);
+                        T*                 c  = C + (ic + ir) + (jc + jr) * ldc;
+                        const T*           a  = pa + ir * kc;
+                        const T*           b  = pb + jr * kc;
+                        if (mr == Blk::MR && nr == Blk::NR)
+                        {
+                            detail::microKernel<Blk::MR / W>(kc, a, b, c, ldc, alpha, bk);
+                            continue;
+                        }
+                        if (mr * 2 <= Blk::MR && W > 1)
+                        {
+                            detail::microKernel<Blk::MR / W / 2>(kc, a, b, edge, Blk::MR, alpha, T(0));
+                        }
+                        else
+                        {
+                            detail::microKernel<Blk::MR / W>(kc, a, b, edge, Blk::MR, alpha, T(0));
+                        }
+                        for (Eigen::Index j = 0; j < nr; j++)
+                        {
+                            for (Eigen::Index i = 0; i < mr; i++)
+                            {
+                                T& cij = c[i + j * ldc];
+                                cij    = bk == T(0) ? edge[i + j * Blk::MR] : bk * cij + edge[i + j * Blk::MR];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/// @brief Computes C = A * B for Eigen column-major matrices or maps with the blocked GEMM.
+/// @param A is the left matrix.
+/// @param B is the right matrix.
+/// @param C is the result, must already have the shape (A.rows(), B.cols()).
+/// @param ws holds the packing buffers.
+template<typename MatA, typename MatB, typename MatC>
+void gemm(const Eigen::DenseBase<MatA>& A, const Eigen::DenseBase<MatB>& B, Eigen::DenseBase<MatC>& C, GemmWorkspace<typename MatC::Scalar>& ws)
+{
+    using T = typename MatC::Scalar;
+    assert(A.cols() == B.rows() && C.rows() == A.rows() && C.cols() == B.cols() && "Incompatible shapes");
+    gemm<T>(A.rows(), B.cols(), A.cols(), T(1), A.derived().data(), A.derived().outerStride(), B.derived().data(),
+            B.derived().outerStride(), T(0), C.derived().data(), C.derived().outerStride(), ws);
+}
+
+
+/// @brief Leaf kernel for strassenMultInPlace computing C = A * B with the blocked GEMM. Each thread keeps its own
+/// packing buffers, so the leaf neither allocates after the first call nor shares state between tasks.
+struct BlockedGemmLeaf
+{
+    template<typename MatA, typename MatB, typename MatC>
+    void operator()(const MatA& A, const MatB& B, MatC C) const
+    {
+        using T = typename MatC::Scalar;
+        thread_local GemmWorkspace<T> ws;
+        gemm<T>(A.rows(), B.cols(), A.cols(), T(1), A.data(), A.outerStride(), B.data(), B.outerStride(), T(0), C.data(),
+                C.outerStride(), ws);
+    }
+};
@@ -0,0 +1,41 @@
+#include <cassert>
+#include <iostream>
+#include <Eigen/Dense>
+
+#include "gemm.hpp"
+
+using Eigen::MatrixXd;
+using Eigen::MatrixXf;
+using std::cout;
+using std::endl;
+
+
+int main()
+{
+    cout << "Micro-tile " << GemmBlocking<float>::MR << "x" << GemmBlocking<float>::NR << " (float), "
+         << GemmBlocking<double>::MR << "x" << GemmBlocking<double>::NR << " (double), "
+         << SimdOps<float>::width << " floats per SIMD register" << endl;
+
+    // Shapes that exercise full tiles, edge tiles and several cache blocks in every dimension
+    GemmWorkspace<float> ws;
+    const int shapes[][3] = {{1, 1, 1}, {7, 5, 3}, {64, 64, 64}, {333, 517, 129}, {1000, 20, 300}, {17, 2000, 600}};
+    for (const auto& s : shapes)
+    {
+        MatrixXf A = MatrixXf::Random(s[0], s[1]);
+        MatrixXf B = MatrixXf::Random(s[1], s[2]);
+        MatrixXf C(s[0], s[2]);
+        gemm(A, B, C, ws);
+        assert(C.isApprox(A * B, 1e-5f) && "Blocked GEMM differs from Eigen");
+    }
+
+    // alpha, beta and leading dimensions larger than the block, in double
+    GemmWorkspace<double> wsd;
+    MatrixXd A = MatrixXd::Random(300, 200), B = MatrixXd::Random(250, 150), C = MatrixXd::Random(280, 160);
+    MatrixXd expected = C;
+    expected.block(0, 0, 280, 140) = 0.5 * expected.block(0, 0, 280, 140) + 2.0 * A.block(0, 0, 280, 190) * B.block(0, 0, 190, 140);
+    gemm<double>(280, 140, 190, 2.0, A.data(), A.rows(), B.data(), B.rows(), 0.5, C.data(), C.rows(), wsd);
+    assert(C.isApprox(expected, 1e-12) && "Blocked GEMM with alpha, beta and strides differs from Eigen");
+
+    cout << "Blocked GEMM succeeded" << endl;
+    return 0;
+}
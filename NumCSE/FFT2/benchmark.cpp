@@ -0,0 +1,133 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
+
+#include "benchmark_stats.hpp"
+#include "fft2_plan.hpp"
+
+using Eigen::Index;
+using Eigen::MatrixXcd;
+using Eigen::MatrixXd;
+using Eigen::VectorXcd;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Best of three timed runs; every run averages over many calls already, so no warmup is needed.
+const BenchmarkOptions kTimedRuns = {.warmup = 0, .minReps = 3, .minTime = 0};
+
+
+/// @brief fft2 as it was before the plan: a new FFT object per call, every row and column copied to a temporary
+/// vector and the result copied back.
+void fft2PerCall(MatrixXcd& C, const MatrixXcd& Y)
+{
+    const Index m = Y.rows();
+    const Index n = Y.cols();
+    C.resize(m, n);
+    MatrixXcd   tmp(m, n);
+    Eigen::FFT<double> fft;
+    for (Index i = 0; i < m; i++)
+    {
+        tmp.row(i) = fft.fwd(((VectorXcd) Y.row(i).transpose())).transpose();
+    }
+    for (Index j = 0; j < n; j++)
+    {
+        C.col(j) = fft.fwd(((VectorXcd) tmp.col(j)));
+    }
+}
+
+
+/// @brief Time per 2D FFT of an (m, n) matrix, over `calls` calls on the same shape as in an image pipeline.
+void benchmark(Index m, Index n, int calls)
+{
+    const MatrixXcd Y = MatrixXcd::Random(m, n);
+    MatrixXcd       C, X;
+
+    const double tPerCall = measure([&] {
+        for (int c = 0; c < calls; c++)
+        {
+            fft2PerCall(C, Y);
+        }
+    }, kTimedRuns).min / calls;
+
+    const double tSetup = measure([&] { FFT2Plan plan(m, n); }, kTimedRuns).min;
+    FFT2Plan     plan(m, n);
+    const double tPlan = measure([&] {
+        for (int c = 0; c < calls; c++)
+        {
+            X = Y;
+            plan.forward(X);
+        }
+    }, kTimedRuns).min / calls;
+
+    cout << setw(6) << m << setw(6) << n << setw(16) << tPerCall * 1e3 << setw(16) << tPlan * 1e3 << setw(12)
+         << tPerCall / tPlan << setw(16) << tSetup * 1e3 << setw(14) << (X - C).norm() / C.norm() << endl;
+}
+
+
+/// @brief Time of a forward and inverse 2D FFT of a real (m, n) matrix, promoted to complex against the
+/// half-spectrum plan, and the memory of the spectrum plus the plan's scratch.
+void benchmarkReal(Index m, Index n, int calls)
+{
+    const MatrixXd Y = MatrixXd::Random(m, n);
+    MatrixXcd      X, H;
+    MatrixXd       Z;
+
+    FFT2Plan     complexPlan(m, n);
+    const double tComplex = measure([&] {
+        for (int c = 0; c < calls; c++)
+        {
+            X = Y.cast<std::complex<double>>();
+            complexPlan.forward(X);
+            complexPlan.inverse(X);
+        }
+    }, kTimedRuns).min / calls;
+
+    RealFFT2Plan realPlan(m, n);
+    const double tReal = measure([&] {
+        for (int c = 0; c < calls; c++)
+        {
+            realPlan.forward(Y, H);
+            realPlan.inverse(H, Z);
+        }
+    }, kTimedRuns).min / calls;
+
+    const double mbComplex = 2.0 * 16.0 * m * n / 1e6;
+    const double mbReal    = 2.0 * 16.0 * realPlan.halfRows() * n / 1e6;
+    cout << setw(6) << m << setw(6) << n << setw(16) << tComplex * 1e3 << setw(16) << tReal * 1e3 << setw(12)
+         << tComplex / tReal << setw(10) << mbComplex << setw(10) << mbReal << setw(14)
+         << (Z - Y).norm() / Y.norm() << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const int calls = argc > 1 ? std::atoi(argv[1]) : 10;
+    cout << "Time per forward 2D FFT, averaged over " << calls << " calls on one shape" << endl;
+    cout << setw(6) << "m" << setw(6) << "n" << setw(16) << "per call [ms]" << setw(16) << "plan [ms]" << setw(12)
+         << "speedup" << setw(16) << "plan setup [ms]" << setw(14) << "rel. diff" << endl;
+
+    benchmark(64, 64, 50 * calls);
+    benchmark(27, 79, 50 * calls);
+    benchmark(256, 256, 4 * calls);
+    benchmark(480, 640, calls);
+    benchmark(1024, 1024, calls);
+    benchmark(2048, 2048, calls / 2 + 1);
+    benchmark(1000, 1500, calls);
+
+    cout << endl << "Real input, forward and inverse 2D FFT: promoted to complex against the half spectrum" << endl;
+    cout << setw(6) << "m" << setw(6) << "n" << setw(16) << "complex [ms]" << setw(16) << "r2c/c2r [ms]" << setw(12)
+         << "speedup" << setw(10) << "MB" << setw(10) << "MB r2c" << setw(14) << "round trip" << endl;
+    benchmarkReal(64, 64, 50 * calls);
+    benchmarkReal(27, 79, 50 * calls);
+    benchmarkReal(256, 256, 4 * calls);
+    benchmarkReal(480, 640, calls);
+    benchmarkReal(1024, 1024, calls);
+    benchmarkReal(2048, 2048, calls / 2 + 1);
+    benchmarkReal(1000, 1500, calls);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iomanip>
+#include <iostream>
+#include <Eigen/Dense>
+
+#include "benchmark_stats.hpp"
+#include "convolution.hpp"
+
+using Eigen::Index;
+using Eigen::MatrixXd;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Best of three timed runs without a warmup, the direct sum on the larger images takes seconds.
+const BenchmarkOptions kTimedRuns = {.warmup = 0, .minReps = 3, .minTime = 0};
+
+
+/// @brief Measured and modelled times of the three algorithms for an (n, n) image and a (k, k) kernel, and the
+/// algorithm the model picks. The measured times calibrate the constants of convolutionCost.
+void benchmark(Index n, Index k)
+{
+    const MatrixXd        A = MatrixXd::Random(n, n), K = MatrixXd::Random(k, k);
+    const ConvolutionCost cost = convolutionCost(n, n, k, k);
+    MatrixXd              C;
+
+    cout << setw(6) << n << setw(5) << k;
+    for (ConvolutionAlgorithm algorithm :
+         {ConvolutionAlgorithm::Direct, ConvolutionAlgorithm::OverlapSave, ConvolutionAlgorithm::FFT})
+    {
+        // The direct sum of large kernels on large images takes minutes and is clearly not the choice
+        if (algorithm == ConvolutionAlgorithm::Direct && cost.direct > 20 * std::min(cost.overlapSave, cost.fft))
+        {
+            cout << setw(12) << "-";
+            continue;
+        }
+        cout << setw(12) << measure([&] { convolve(A, K, C, algorithm); }, kTimedRuns).min * 1e3;
+    }
+    cout << setw(12) << cost.direct * 1e3 << setw(12) << cost.overlapSave * 1e3 << setw(12) << cost.fft * 1e3
+         << setw(7) << cost.tileRows << setw(14) << convolutionName(cost.cheapest()) << endl;
+}
+
+
+/// @brief The FFT convolution as it was before the prepared filter: the kernel transformed again for every frame,
+/// at the exact size of the result, whatever its prime factors.
+void convolveExactSize(const MatrixXd& A, const MatrixXd& K, MatrixXd& C)
+{
+    const Index      rows = A.rows() + K.rows() - 1, cols = A.cols() + K.cols() - 1;
+    MatrixXd         padded = MatrixXd::Zero(rows, cols);
+    Eigen::MatrixXcd hatA, hatK;
+    RealFFT2Plan&    plan = realFFT2Plan(rows, cols);
+
+    padded.topLeftCorner(A.rows(), A.cols()) = A;
+    plan.forward(padded, hatA);
+    padded.setZero();
+    padded.topLeftCorner(K.rows(), K.cols()) = K;
+    plan.forward(padded, hatK);
+    hatA.array() *= hatK.array();
+    plan.inverse(hatA, C);
+}
+
+
+/// @brief Time per frame of convolving `frames` (n1, m1) frames with one (k1, k2) kernel: three FFTs per frame at
+/// the exact size, against the prepared filter with one forward and one inverse FFT per frame at a smooth size.
+void benchmarkFrames(Index n1, Index m1, Index k1, Index k2, int frames)
+{
+    const MatrixXd K = MatrixXd::Random(k1, k2);
+    const MatrixXd A = MatrixXd::Random(n1, m1);
+    MatrixXd       C, P;
+
+    const double tExact = measure([&] {
+        for (int f = 0; f < frames; f++)
+        {
+            convolveExactSize(A, K, C);
+        }
+    }, kTimedRuns).min / frames;
+
+    const double   tSetup = measure([&] { PreparedFilter(K, n1, m1); }, kTimedRuns).min;
+    PreparedFilter filter(K, n1, m1);
+    const double   tPrepared = measure([&] {
+        for (int f = 0; f < frames; f++)
+        {
+            filter.apply(A, P);
+        }
+    }, kTimedRuns).min / frames;
+
+    cout << setw(6) << n1 << setw(6) << m1 << setw(4) << k1 << setw(4) << k2 << setw(6) << n1 + k1 - 1 << setw(6)
+         << m1 + k2 - 1 << setw(6) << filter.fftRows() << setw(6) << filter.fftCols() << setw(14) << tExact * 1e3
+         << setw(14) << tPrepared * 1e3 << setw(10) << tExact / tPrepared << setw(12) << tSetup * 1e3 << setw(12)
+         << (P - C).norm() / C.norm() << endl;
+}
+
+
+int main()
+{
+    cout << "Full 2D convolution of an (n, n) image with a (k, k) kernel, measured and modelled times [ms]" << endl;
+    cout << setw(6) << "n" << setw(5) << "k" << setw(12) << "direct" << setw(12) << "ov.-save" << setw(12) << "FFT"
+         << setw(12) << "model dir." << setw(12) << "model o.-s." << setw(12) << "model FFT" << setw(7) << "tile"
+         << setw(14) << "choice" << endl;
+
+    for (Index n : {256, 1024, 2048})
+    {
+        for (Index k : {3, 5, 9, 15, 31, 63, 127})
+        {
+            benchmark(n, k);
+        }
+    }
+    benchmark(500, 400);
+
+    cout << endl << "Time per frame of a stream of frames filtered with one kernel [ms]" << endl;
+    cout << setw(6) << "n1" << setw(6) << "m1" << setw(4) << "k1" << setw(4) << "k2" << setw(12) << "exact size"
+         << setw(12) << "FFT size" << setw(14) << "per frame" << setw(14) << "prepared" << setw(10) << "speedup"
+         << setw(12) << "setup" << setw(12) << "rel. diff" << endl;
+    benchmarkFrames(25, 73, 3, 7, 2000);
+    benchmarkFrames(250, 250, 31, 31, 50);
+    benchmarkFrames(480, 640, 31, 31, 10);
+    benchmarkFrames(1000, 1500, 25, 25, 3);
+    benchmarkFrames(1024, 1024, 129, 129, 3);
+
+    return 0;
+}
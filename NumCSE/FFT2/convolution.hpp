@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "fft2_plan.hpp"
+
+
+// Full 2D convolutions C = A * K of an (n1, m1) image A and an (k1, k2) kernel K, C of size
+// (n1 + k1 - 1, m1 + k2 - 1), as conv2 computes them, by three algorithms:
+//   Direct       the sum over the kernel, O(n1 m1 k1 k2), best for small kernels;
+//   OverlapSave  FFTs of image tiles of a fixed small size against the kernel transformed once at that size,
+//                O(n1 m1 log(tile)), best for medium kernels on large images;
+//   FFT          one FFT of the whole zero-padded problem, best when the kernel is about as large as the image.
+// convolutionCost estimates the cost of each from the sizes and convolve runs the cheapest. PreparedFilter keeps
+// the transformed kernel for convolving many frames of one shape.
+
+enum class ConvolutionAlgorithm
+{
+    Automatic,
+    Direct,
+    OverlapSave,
+    FFT
+};
+
+
+inline const char* convolutionName(ConvolutionAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+        case ConvolutionAlgorithm::Direct: return "direct";
+        case ConvolutionAlgorithm::OverlapSave: return "overlap-save";
+        case ConvolutionAlgorithm::FFT: return "FFT";
+        default: return "automatic";
+    }
+}
+
+
+/// @brief Estimated costs of the algorithms for one problem, in seconds of one core, and the FFT size of the
+/// overlap-save tiles.
+struct ConvolutionCost
+{
+    double       direct;
+    double       overlapSave;
+    double       fft;
+    Eigen::Index tileRows;
+    Eigen::Index tileCols;
+
+    ConvolutionAlgorithm cheapest() const
+    {
+        if (direct <= overlapSave && direct <= fft)
+        {
+            return ConvolutionAlgorithm::Direct;
+        }
+        return overlapSave <= fft ? ConvolutionAlgorithm::OverlapSave : ConvolutionAlgorithm::FFT;
+    }
+};
+
+
+namespace detail
+{
+/// @brief Seconds per output entry and per multiply-add of the vectorized direct sum, per flop of a real 2D FFT
+/// counted as 2.5 N log2(N) for N points, and per 1D transform it runs, which dominates small tiles. Measured with
+/// benchmark_convolution at -O2; only their ratios matter for the choice.
+constexpr double kDirectSecondsPerOutput      = 1.0e-9;
+constexpr double kDirectSecondsPerMultiplyAdd = 0.2e-9;
+constexpr double kFFTSecondsPerFlop           = 0.35e-9;
+constexpr double kFFTSecondsPerLine           = 0.1e-6;
+
+/// @brief Fraction of the realFFTSeconds estimate that overlap-save tiles take: they are transformed serially, each
+/// by one thread at most 512 x 512 points, and stay in cache, while the constants above are fitted to the full
+/// transform. Without it the model overestimated the tiles by 1.3 to 1.7 times and chose the full FFT for a
+/// (2048, 2048) image and a (127, 127) kernel, where overlap-save is 1.4 times faster.
+constexpr double kTileCostScale = 0.7;
+
+/// @brief Tile FFT sizes tried by overlap-save, in each direction: fast sizes from twice the kernel up to this.
+constexpr Eigen::Index kMaxTileSize = 512;
+
+/// @brief FFT work per point of a length, in radix-2 stages: log2(p) for each factor p of 2, 3 or 5, which kissfft
+/// has butterflies for, and p for every other prime factor, which goes through its O(p^2) generic butterfly.
+inline double fftLengthFactor(Eigen::Index n)
+{
+    double factor = 0;
+    for (Eigen::Index p = 2; n > 1; p++)
+    {
+        for (; n % p == 0; n /= p)
+        {
+            factor += p <= 5 ? std::log2(double(p)) : double(p);
+        }
+    }
+    return factor;
+}
+
+/// @brief Estimated seconds of a forward or an inverse real 2D FFT of (rows, cols) points: cols column transforms
+/// and rows / 2 + 1 row transforms of the half spectrum, 2.5 N log2(N) flops for N points at 2-3-5 smooth sizes.
+inline double realFFTSeconds(Eigen::Index rows, Eigen::Index cols)
+{
+    const double points = double(rows) * double(cols);
+    const double lines  = double(cols) + double(rows / 2 + 1);
+    return points > 1 ? 2.5 * points * (fftLengthFactor(rows) + fftLengthFactor(cols)) * kFFTSecondsPerFlop +
+                            lines * kFFTSecondsPerLine
+                      : 0;
+}
+
+/// @brief Smallest tile FFT size 2^a or 3 2^a at least n, both fast for kissfft.
+inline Eigen::Index nextTileSize(Eigen::Index n)
+{
+    Eigen::Index size = 1;
+    while (size < n)
+    {
+        size *= 2;
+    }
+    // 3 2^(a-2) lies between 2^(a-1) and 2^a
+    return size % 4 == 0 && 3 * (size / 4) >= n ? 3 * (size / 4) : size;
+}
+
+/// @brief Estimated seconds of the product of two half spectra of (rows, cols) points, 6 flops per entry.
+inline double spectrumProductSeconds(Eigen::Index rows, Eigen::Index cols)
+{
+    return 6.0 * double(rows / 2 + 1) * double(cols) * kFFTSecondsPerFlop;
+}
+
+/// @brief Overlap-save along one direction: number of tiles of the output length for a tile FFT size.
+inline Eigen::Index tileCount(Eigen::Index outputLength, Eigen::Index kernelLength, Eigen::Index tileSize)
+{
+    const Eigen::Index valid = tileSize - kernelLength + 1;
+    return (outputLength + valid - 1) / valid;
+}
+} // namespace detail
+
+
+/// @brief Estimated cost of each algorithm for an (n1, m1) image and a (k1, k2) kernel, with the best tile size
+/// for overlap-save among the sizes 2^a and 3 2^a at least twice the kernel.
+inline ConvolutionCost convolutionCost(Eigen::Index n1, Eigen::Index m1, Eigen::Index k1, Eigen::Index k2)
+{
+    const Eigen::Index rows = n1 + k1 - 1;
+    const Eigen::Index cols = m1 + k2 - 1;
+
+    ConvolutionCost cost;
+    cost.direct = double(n1) * double(m1) *
+                  (detail::kDirectSecondsPerOutput + double(k1) * double(k2) * detail::kDirectSecondsPerMultiplyAdd);
+
+    const Eigen::Index paddedRows = fastFFTSize(rows), paddedCols = fastFFTSize(cols);
+    cost.fft = 3 * detail::realFFTSeconds(paddedRows, paddedCols) +
+               detail::spectrumProductSeconds(paddedRows, paddedCols);
+
+    // Each tile costs a forward and an inverse FFT and the product; the kernel is transformed once
+    cost.overlapSave = std::numeric_limits<double>::infinity();
+    cost.tileRows    = rows;
+    cost.tileCols    = cols;
+    auto candidates  = [](Eigen::Index kernel, Eigen::Index output) {
+        std::vector<Eigen::Index> sizes;
+        const Eigen::Index smallest = detail::nextTileSize(2 * kernel);
+        const Eigen::Index largest  = std::max(detail::kMaxTileSize, smallest);
+        for (Eigen::Index size = smallest; size <= largest; size = detail::nextTileSize(size + 1))
+        {
+            sizes.push_back(size);
+            // A tile larger than the padded output is the plain FFT
+            if (size >= output + kernel - 1)
+            {
+                break;
+            }
+        }
+        return sizes;
+    };
+    for (Eigen::Index t1 : candidates(k1, rows))
+    {
+        for (Eigen::Index t2 : candidates(k2, cols))
+        {
+            const double tiles = double(detail::tileCount(rows, k1, t1)) * double(detail::tileCount(cols, k2, t2));
+            const double c     = detail::kTileCostScale *
+                             (detail::realFFTSeconds(t1, t2) +
+                              tiles * (2 * detail::realFFTSeconds(t1, t2) + detail::spectrumProductSeconds(t1, t2)));
+            if (c < cost.overlapSave)
+            {
+                cost.overlapSave = c;
+                cost.tileRows    = t1;
+                cost.tileCols    = t2;
+            }
+        }
+    }
+    return cost;
+}
+
+
+/// @brief Direct full convolution, for real or complex matrices. Every output column is a sum of k2 shifted
+/// input columns, each added k1 times with a shift; these are contiguous axpys the compiler vectorizes, and
+/// the output column being summed stays in cache. Output columns are independent and split over the threads.
+template<typename Scalar>
+void convolveDirect(const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& A,
+                    const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& K,
+                    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>&       C)
+{
+    const Eigen::Index n1 = A.rows(), m1 = A.cols(), k1 = K.rows(), k2 = K.cols();
+    const Eigen::Index cols = m1 + k2 - 1;
+    C.setZero(n1 + k1 - 1, cols);
+
+    [[maybe_unused]] const bool parallel = double(n1) * m1 * k1 * k2 >= detail::kParallelMinimum;
+    #pragma omp parallel for schedule(static) if (parallel)
+    for (Eigen::Index j = 0; j < cols; j++)
+    {
+        Scalar* c = C.col(j).data();
+        for (Eigen::Index q = std::max<Eigen::Index>(0, j - m1 + 1); q <= std::min(k2 - 1, j); q++)
+        {
+            const Scalar* a = A.col(j - q).data();
+            for (Eigen::Index p = 0; p < k1; p++)
+            {
+                const Scalar k  = K(p, q);
+                Scalar*      cp = c + p;
+                #pragma omp simd
+                for (Eigen::Index i = 0; i < n1; i++)
+                {
+                    cp[i] += k * a[i];
+                }
+            }
+        }
+    }
+}
+
+
+/// @brief A real kernel transformed once, for the full convolutions of many real frames of one shape, as in a video
+/// or an image pipeline. The transforms are padded from the (n1 + k1 - 1, m1 + k2 - 1) size of the result to the next
+/// 2-3-5 smooth sizes, where the FFT is fast; the cyclic convolution at that size is the full one followed by zeros.
+/// Each frame then costs one forward and one inverse FFT. apply uses the buffers of the filter, so a filter serves
+/// one thread at a time.
+class PreparedFilter
+{
+  public:
+    /// @brief Constructor
+    /// @param K is the real (k1, k2) kernel.
+    /// @param n1 is the number of rows of the frames.
+    /// @param m1 is the number of columns of the frames.
+    /// @param threads is the number of threads of the FFTs, 0 for one per OpenMP thread, 1 to run serially.
+    PreparedFilter(const Eigen::MatrixXd& K, Eigen::Index n1, Eigen::Index m1, int threads = 0)
+    : n1(n1)
+    , m1(m1)
+    , rows(n1 + K.rows() - 1)
+    , cols(m1 + K.cols() - 1)
+    , plan(fastFFTSize(rows), fastFFTSize(cols), threads)
+    , padded(Eigen::MatrixXd::Zero(plan.rows(), plan.cols()))
+    {
+        assert(K.size() > 0 && n1 > 0 && m1 > 0);
+        padded.topLeftCorner(K.rows(), K.cols()) = K;
+        plan.forward(padded, hatK);
+        padded.topLeftCorner(K.rows(), K.cols()).setZero();
+    }
+
+    /// @brief Size of the padded transforms.
+    Eigen::Index fftRows() const { return plan.rows(); }
+    Eigen::Index fftCols() const { return plan.cols(); }
+
+    /// @brief Full convolution of a frame with the kernel.
+    /// @param A is the real (n1, m1) frame.
+    /// @param C is set to the (n1 + k1 - 1, m1 + k2 - 1) convolution.
+    void apply(const Eigen::MatrixXd& A, Eigen::MatrixXd& C)
+    {
+        assert(A.rows() == n1 && A.cols() == m1);
+        // Outside the top left corner the padded frame stays zero from the constructor
+        padded.topLeftCorner(n1, m1) = A;
+        plan.forward(padded, hat);
+        hat.array() *= hatK.array();
+        plan.inverse(hat, cyclic);
+        C = cyclic.topLeftCorner(rows, cols);
+    }
+
+  private:
+    Eigen::Index     n1, m1, rows, cols;
+    RealFFT2Plan     plan;
+    Eigen::MatrixXd  padded, cyclic;
+    Eigen::MatrixXcd hatK, hat;
+};
+
+
+/// @brief Full convolution of real matrices by one FFT of the whole zero-padded problem, with the kernel prepared
+/// for this one frame.
+inline void convolveFFT(const Eigen::MatrixXd& A, const Eigen::MatrixXd& K, Eigen::MatrixXd& C)
+{
+    PreparedFilter(K, A.rows(), A.cols()).apply(A, C);
+}
+
+
+/// @brief Full convolution of real matrices by overlap-save on (t1, t2) tiles: the kernel is transformed once at
+/// the tile size; each output block of (t1 - k1 + 1, t2 - k2 + 1) entries comes from the cyclic convolution of
+/// the input tile that ends at it, whose first k1 - 1 rows and k2 - 1 columns are wrapped around and dropped.
+/// Output blocks do not overlap, so the threads take whole tiles, each with its own serial plan and buffers.
+/// @param t1 is the FFT size of the tiles along the rows, at least k1, best a size with small prime factors.
+/// @param t2 is the FFT size along the columns, at least k2.
+inline void convolveOverlapSave(const Eigen::MatrixXd& A, const Eigen::MatrixXd& K, Eigen::MatrixXd& C,
+                                Eigen::Index t1, Eigen::Index t2)
+{
+    const Eigen::Index n1 = A.rows(), m1 = A.cols(), k1 = K.rows(), k2 = K.cols();
+    const Eigen::Index rows = n1 + k1 - 1, cols = m1 + k2 - 1;
+    assert(t1 >= k1 && t2 >= k2);
+    const Eigen::Index b1 = t1 - k1 + 1, b2 = t2 - k2 + 1;
+    const Eigen::Index tiles1 = detail::tileCount(rows, k1, t1), tiles2 = detail::tileCount(cols, k2, t2);
+    C.resize(rows, cols);
+
+    Eigen::MatrixXcd hatK;
+    {
+        RealFFT2Plan    plan(t1, t2, 1);
+        Eigen::MatrixXd padded = Eigen::MatrixXd::Zero(t1, t2);
+        padded.topLeftCorner(k1, k2) = K;
+        plan.forward(padded, hatK);
+    }
+
+    #pragma omp parallel
+    {
+        RealFFT2Plan     plan(t1, t2, 1);
+        Eigen::MatrixXd  tile(t1, t2), cyclic;
+        Eigen::MatrixXcd hat;
+
+        #pragma omp for schedule(dynamic)
+        for (Eigen::Index t = 0; t < tiles1 * tiles2; t++)
+        {
+            // Output block at (r0, c0) reads the input from (r0 - k1 + 1, c0 - k2 + 1), zero outside A
+            const Eigen::Index r0 = (t % tiles1) * b1, c0 = (t / tiles1) * b2;
+            const Eigen::Index i0 = r0 - k1 + 1, j0 = c0 - k2 + 1;
+            const Eigen::Index iBegin = std::max<Eigen::Index>(i0, 0), iEnd = std::min(i0 + t1, n1);
+            const Eigen::Index jBegin = std::max<Eigen::Index>(j0, 0), jEnd = std::min(j0 + t2, m1);
+            tile.setZero();
+            if (iBegin < iEnd && jBegin < jEnd)
+            {
+                tile.block(iBegin - i0, jBegin - j0, iEnd - iBegin, jEnd - jBegin) =
+                    A.block(iBegin, jBegin, iEnd - iBegin, jEnd - jBegin);
+            }
+            plan.forward(tile, hat);
+            hat.array() *= hatK.array();
+            plan.inverse(hat, cyclic);
+            const Eigen::Index r = std::min(b1, rows - r0), c = std::min(b2, cols - c0);
+            C.block(r0, c0, r, c) = cyclic.block(k1 - 1, k2 - 1, r, c);
+        }
+    }
+}
+
+
+/// @brief Full convolution C = A * K of real matrices with the given algorithm, by default the cheapest one by
+/// convolutionCost. The convolution is symmetric, so the smaller operand plays the kernel.
+/// @return The algorithm used.
+inline ConvolutionAlgorithm convolve(const Eigen::MatrixXd& A, const Eigen::MatrixXd& K, Eigen::MatrixXd& C,
+                                     ConvolutionAlgorithm algorithm = ConvolutionAlgorithm::Automatic)
+{
+    assert(A.size() > 0 && K.size() > 0);
+    if (K.size() > A.size())
+    {
+        return convolve(K, A, C, algorithm);
+    }
+    const ConvolutionCost cost = convolutionCost(A.rows(), A.cols(), K.rows(), K.cols());
+    if (algorithm == ConvolutionAlgorithm::Automatic)
+    {
+        algorithm = cost.cheapest();
+    }
+    switch (algorithm)
+    {
+        case ConvolutionAlgorithm::Direct: convolveDirect(A, K, C); break;
+        case ConvolutionAlgorithm::OverlapSave: convolveOverlapSave(A, K, C, cost.tileRows, cost.tileCols); break;
+        default: convolveFFT(A, K, C); break;
+    }
+    return algorithm;
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <complex>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <Eigen/Dense>
+#include <unsupported/Eigen/FFT>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+namespace detail
+{
+/// @brief Edge of the square tiles of the blocked transpose: a 16 x 16 tile of complex doubles is 4 KB, so the
+/// source and destination tiles stay in L1 even when power-of-two strides map their lines to few cache sets.
+constexpr Eigen::Index kTransposeBlock = 16;
+
+/// @brief Passes over fewer entries run on one thread, the fork and join would cost more than they save.
+constexpr Eigen::Index kParallelMinimum = 1 << 15;
+
+/// @brief Number of threads for a plan, 0 or less for one per OpenMP thread.
+inline int threadCount(int threads)
+{
+    if (threads > 0)
+    {
+        return threads;
+    }
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline int threadId()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/// @brief Cache-blocked out-of-place transpose dst = scale * src^T of column-major arrays, the row tiles spread
+/// over the threads.
+/// @param src is the (rows, cols) source.
+/// @param dst is the (cols, rows) destination, it must not overlap src.
+/// @param scale multiplies every entry on the way, so a normalization costs no extra pass.
+inline void transposeBlocked(const std::complex<double>* src, Eigen::Index rows, Eigen::Index cols,
+                             std::complex<double>* dst, double scale = 1.0, [[maybe_unused]] int threads = 1)
+{
+    const Eigen::Index          tiles    = (rows + kTransposeBlock - 1) / kTransposeBlock;
+    [[maybe_unused]] const bool parallel = threads > 1 && rows * cols >= kParallelMinimum;
+    #pragma omp parallel for schedule(static) num_threads(threads) if (parallel)
+    for (Eigen::Index t = 0; t < tiles; t++)
+    {
+        const Eigen::Index i0 = t * kTransposeBlock;
+        const Eigen::Index i1 = std::min(i0 + kTransposeBlock, rows);
+        for (Eigen::Index j0 = 0; j0 < cols; j0 += kTransposeBlock)
+        {
+            const Eigen::Index j1 = std::min(j0 + kTransposeBlock, cols);
+            // Contiguous writes, the strided reads of a tile hit the lines loaded for its first row
+            for (Eigen::Index i = i0; i < i1; i++)
+            {
+                for (Eigen::Index j = j0; j < j1; j++)
+                {
+                    dst[j + i * cols] = scale * src[i + j * rows];
+                }
+            }
+        }
+    }
+}
+
+/// @brief 1D FFTs of the contiguous columns of column-major arrays, out of place, the columns spread over the
+/// threads with one FFT object each, since kissfft keeps scratch memory in the object. Complex to complex goes
+/// in the direction `inverse` asks for, real to complex is a forward transform to the half spectrum of
+/// length / 2 + 1 and complex to real the inverse of it; the strides say how far apart the columns are.
+template<typename Src, typename Dst>
+void fftColumns(std::vector<Eigen::FFT<double>>& ffts, const Src* src, Eigen::Index srcStride, Dst* dst,
+                Eigen::Index dstStride, Eigen::Index length, Eigen::Index count, bool inverse = false)
+{
+    [[maybe_unused]] const int  threads  = static_cast<int>(ffts.size());
+    [[maybe_unused]] const bool parallel = threads > 1 && length * count >= kParallelMinimum;
+    #pragma omp parallel for schedule(static) num_threads(threads) if (parallel)
+    for (Eigen::Index j = 0; j < count; j++)
+    {
+        Eigen::FFT<double>& fft = ffts[threadId()];
+        const Src*          in  = src + j * srcStride;
+        Dst*                out = dst + j * dstStride;
+        // The FFT of length 1 is the identity, and kissfft has no scratch for its radix-1 stage
+        if (length == 1)
+        {
+            if constexpr (std::is_same_v<Dst, double>)
+            {
+                *out = std::real(*in);
+            }
+            else
+            {
+                *out = *in;
+            }
+        }
+        else if constexpr (std::is_same_v<Src, double>)
+        {
+            fft.fwd(out, in, length);
+        }
+        else if constexpr (std::is_same_v<Dst, double>)
+        {
+            fft.inv(out, in, length);
+        }
+        else if (inverse)
+        {
+            fft.inv(out, in, length);
+        }
+        else
+        {
+            fft.fwd(out, in, length);
+        }
+    }
+}
+
+/// @brief One FFT object per thread with the given flags and the 1D plans of the lengths already built, which
+/// kissfft otherwise does at the first transform of a length.
+/// @param realLength also builds the plans of the real transforms of this length, 0 for none.
+inline std::vector<Eigen::FFT<double>> makeFFTs(int threads, int flags, std::initializer_list<Eigen::Index> lengths,
+                                                Eigen::Index realLength = 0)
+{
+    std::vector<Eigen::FFT<double>> ffts(threads);
+    for (Eigen::FFT<double>& fft : ffts)
+    {
+        if (flags != 0)
+        {
+            fft.SetFlag(static_cast<Eigen::FFT<double>::Flag>(flags));
+        }
+        for (Eigen::Index length : lengths)
+        {
+            if (length > 1)
+            {
+                std::vector<std::complex<double>> in(length), out(length);
+                fft.fwd(out.data(), in.data(), length);
+                fft.inv(out.data(), in.data(), length);
+            }
+        }
+        if (realLength > 1)
+        {
+            std::vector<double>               x(realLength);
+            std::vector<std::complex<double>> y(realLength);
+            fft.fwd(y.data(), x.data(), realLength);
+            fft.inv(x.data(), y.data(), realLength);
+        }
+    }
+    return ffts;
+}
+} // namespace detail
+
+
+/// @brief Smallest length >= n whose only prime factors are 2, 3 and 5. kissfft has dedicated butterflies for
+/// these radices and falls back to an O(p^2) one for every other prime p, so zero-padding a convolution to such
+/// a length is usually cheaper than transforming its exact length.
+inline Eigen::Index fastFFTSize(Eigen::Index n)
+{
+    for (Eigen::Index size = std::max<Eigen::Index>(n, 1);; size++)
+    {
+        Eigen::Index rest = size;
+        for (Eigen::Index p : {2, 3, 5})
+        {
+            while (rest % p == 0)
+            {
+                rest /= p;
+            }
+        }
+        if (rest == 1)
+        {
+            return size;
+        }
+    }
+}
+
+
+/// @brief Column-major (length, count) array, zero-initialized by first touch: each column is first written, with
+/// zeros, by the thread that later works on it. Linux places a page on the NUMA node of the thread that first writes
+/// it, and the static schedule over columns below is the one of the first column pass of a plan of the same
+/// (length, count) shape, so each thread finds its columns in local memory there. The later passes read and write
+/// the same storage as (count, length) columns, and their split over the threads does not follow these pages, so the
+/// placement only covers the first pass. A std::vector or an Eigen matrix of complex numbers would zero everything
+/// from the allocating thread alone and put it all on one node. Wrap it in an Eigen::Map to use it as a matrix.
+template<typename T>
+class FirstTouchBuffer
+{
+  public:
+    /// @brief Constructor
+    /// @param length is the number of rows, the entries of a column.
+    /// @param count is the number of columns.
+    /// @param threads is the number of threads that touch the columns, 0 for one per OpenMP thread.
+    FirstTouchBuffer(Eigen::Index length, Eigen::Index count, int threads = 0)
+    : entries(length * count)
+    , buffer(static_cast<T*>(::operator new(sizeof(T) * std::max<Eigen::Index>(entries, 1))))
+    {
+        [[maybe_unused]] const int t = detail::threadCount(threads);
+        T*        p = buffer.get();
+        #pragma omp parallel for schedule(static) num_threads(t) if (t > 1)
+        for (Eigen::Index j = 0; j < count; j++)
+        {
+            std::uninitialized_fill(p + j * length, p + (j + 1) * length, T(0));
+        }
+    }
+
+    T*           data() { return buffer.get(); }
+    const T*     data() const { return buffer.get(); }
+    Eigen::Index size() const { return entries; }
+
+  private:
+    struct Free
+    {
+        void operator()(T* p) const { ::operator delete(p); }
+    };
+
+    Eigen::Index             entries;
+    std::unique_ptr<T, Free> buffer;
+};
+
+
+/// @brief Reusable 2D FFT for one shape (m, n), for code that transforms many matrices of the same size.
+///
+/// The constructor builds the 1D plans of length m and n, forward and inverse, so the twiddle factors are
+/// computed once, and allocates the scratch matrix. The 1D FFT works out of place, so a transform ping-pongs
+/// between the storage of the input and the scratch: the column FFTs go from the contiguous columns of X to the
+/// scratch, a cache-blocked transpose brings the result back into the storage of X with the rows now contiguous,
+/// the row FFTs go to the scratch again and a second blocked transpose writes the result to X. No line is ever
+/// copied and no call allocates.
+///
+/// With several threads the lines of each pass and the row tiles of each transpose are split statically over
+/// them, every thread with its own 1D FFT object; the passes are independent, so only the joins between them
+/// synchronize. The scratch is first touched with the split of the first column pass; the other passes work on
+/// it transposed and get no NUMA placement of their own.
+class FFT2Plan
+{
+  public:
+    using Complex = std::complex<double>;
+    using Matrix  = Eigen::MatrixXcd;
+
+    /// @brief Constructor
+    /// @param m is the number of rows of the matrices to transform.
+    /// @param n is the number of columns.
+    /// @param threads is the number of threads of the passes, 0 for one per OpenMP thread, 1 to run serially.
+    FFT2Plan(Eigen::Index m, Eigen::Index n, int threads = 0)
+    : m(m)
+    , n(n)
+    , threads(detail::threadCount(threads))
+    // Inverse lines are not scaled by 1 / length, the final transpose scales by 1 / (m n) instead
+    , ffts(detail::makeFFTs(this->threads, Eigen::FFT<double>::Unscaled, {m, n}))
+    , scratch(m, n, this->threads)
+    {
+    }
+
+    Eigen::Index rows() const { return m; }
+    Eigen::Index cols() const { return n; }
+    int          threadCount() const { return threads; }
+
+    /// @brief In-place forward transform X <- F_m X F_n.
+    /// @param X is an (m, n) matrix or a map of contiguous memory, e.g. of a FirstTouchBuffer.
+    void forward(Eigen::Ref<Matrix> X) { transform(X, false); }
+
+    /// @brief In-place inverse transform, including the 1 / (m n) normalization, so inverse(forward(X)) == X.
+    void inverse(Eigen::Ref<Matrix> X) { transform(X, true); }
+
+  private:
+    void transform(Eigen::Ref<Matrix>& X, bool inverse)
+    {
+        assert(X.rows() == m && X.cols() == n && X.outerStride() == m);
+        if (m == 0 || n == 0)
+        {
+            return;
+        }
+        // Columns of X, then rows of X as the columns of its transpose, which reuses the storage of X
+        detail::fftColumns(ffts, X.data(), m, scratch.data(), m, m, n, inverse);
+        detail::transposeBlocked(scratch.data(), m, n, X.data(), 1.0, threads);
+        detail::fftColumns(ffts, X.data(), n, scratch.data(), n, n, m, inverse);
+        detail::transposeBlocked(scratch.data(), n, m, X.data(), inverse ? 1.0 / (double(m) * double(n)) : 1.0,
+                                 threads);
+    }
+
+    Eigen::Index                    m, n;
+    int                             threads;
+    std::vector<Eigen::FFT<double>> ffts;
+    FirstTouchBuffer<Complex>       scratch;
+};
+
+
+/// @brief Reusable 2D FFT of real (m, n) matrices, which keeps only the Hermitian half of the spectrum.
+///
+/// The spectrum of a real X satisfies Xhat(i, j) = conj(Xhat(-i mod m, -j mod n)), so its first m / 2 + 1 rows
+/// determine it. The forward transform runs real-to-complex FFTs on the columns of X, which give exactly these
+/// rows, and complex FFTs on the rows of the half spectrum only; the inverse runs the same steps backwards with
+/// complex-to-real FFTs on the columns. Against promoting X to complex this halves the work and the memory of
+/// both the spectrum and the scratch. The passes ping-pong between the spectrum and the scratch and are split
+/// over the threads as in FFT2Plan. The half spectrum H is resized by the caller's thread, so its pages are placed
+/// wherever they are first written; first touch of the scratch again only matches the first column pass.
+class RealFFT2Plan
+{
+  public:
+    using Complex = std::complex<double>;
+
+    /// @brief Constructor
+    /// @param m is the number of rows of the real matrices to transform.
+    /// @param n is the number of columns.
+    /// @param threads is the number of threads of the passes, 0 for one per OpenMP thread, 1 to run serially.
+    RealFFT2Plan(Eigen::Index m, Eigen::Index n, int threads = 0)
+    : m(m)
+    , n(n)
+    , half(m / 2 + 1)
+    , threads(detail::threadCount(threads))
+    // No reflection of the half spectrum of a real line, no 1 / length per line
+    , ffts(detail::makeFFTs(this->threads, Eigen::FFT<double>::HalfSpectrum | Eigen::FFT<double>::Unscaled, {m, n},
+                            m))
+    , scratch(half, n, this->threads)
+    {
+    }
+
+    Eigen::Index rows() const { return m; }
+    Eigen::Index cols() const { return n; }
+    int          threadCount() const { return threads; }
+
+    /// @brief Number of rows of the half spectrum, m / 2 + 1.
+    Eigen::Index halfRows() const { return half; }
+
+    /// @brief Forward transform of a real matrix.
+    /// @param X is the real (m, n) matrix.
+    /// @param H is set to the first m / 2 + 1 rows of F_m X F_n.
+    void forward(const Eigen::Ref<const Eigen::MatrixXd>& X, Eigen::MatrixXcd& H)
+    {
+        assert(X.rows() == m && X.cols() == n && X.outerStride() == m);
+        H.resize(half, n);
+        if (m == 0 || n == 0)
+        {
+            return;
+        }
+        detail::fftColumns(ffts, X.data(), m, scratch.data(), half, m, n);
+        detail::transposeBlocked(scratch.data(), half, n, H.data(), 1.0, threads);
+        detail::fftColumns(ffts, H.data(), n, scratch.data(), n, n, half);
+        detail::transposeBlocked(scratch.data(), n, half, H.data(), 1.0, threads);
+    }
+
+    /// @brief Inverse transform of a half spectrum, including the 1 / (m n) normalization.
+    /// @param H is the (m / 2 + 1, n) half spectrum, it is used as workspace and overwritten.
+    /// @param X is set to the real (m, n) matrix whose spectrum H is.
+    void inverse(Eigen::MatrixXcd& H, Eigen::MatrixXd& X)
+    {
+        assert(H.rows() == half && H.cols() == n);
+        X.resize(m, n);
+        if (m == 0 || n == 0)
+        {
+            return;
+        }
+        detail::transposeBlocked(H.data(), half, n, scratch.data(), 1.0, threads);
+        detail::fftColumns(ffts, scratch.data(), n, H.data(), n, n, half, true);
+        detail::transposeBlocked(H.data(), n, half, scratch.data(), 1.0 / (double(m) * double(n)), threads);
+        detail::fftColumns(ffts, scratch.data(), half, X.data(), m, m, n);
+    }
+
+  private:
+    Eigen::Index                    m, n, half;
+    int                             threads;
+    std::vector<Eigen::FFT<double>> ffts;
+    FirstTouchBuffer<Complex>       scratch;
+};
+
+
+/// @brief Full (m, n) spectrum of a real matrix from its half spectrum, by the Hermitian symmetry.
+/// @param H is the (m / 2 + 1, n) half spectrum.
+/// @param m is the number of rows of the real matrix.
+/// @param C is set to the full spectrum.
+inline void hermitianFullSpectrum(const Eigen::MatrixXcd& H, Eigen::Index m, Eigen::MatrixXcd& C)
+{
+    const Eigen::Index half = H.rows();
+    const Eigen::Index n    = H.cols();
+    assert(half == m / 2 + 1);
+    C.resize(m, n);
+    C.topRows(half) = H;
+    for (Eigen::Index j = 0; j < n; j++)
+    {
+        const Eigen::Index jMirror = j == 0 ? 0 : n - j;
+        for (Eigen::Index i = half; i < m; i++)
+        {
+            C(i, j) = std::conj(H(m - i, jMirror));
+        }
+    }
+}
+
+
+/// @brief Plan of the current thread for the shape (m, n), rebuilt only when the shape changes, so repeated
+/// calls of fft2 and ifft2 on one shape share the twiddles and buffers.
+inline FFT2Plan& fft2Plan(Eigen::Index m, Eigen::Index n)
+{
+    thread_local std::unique_ptr<FFT2Plan> plan;
+    if (!plan || plan->rows() != m || plan->cols() != n)
+    {
+        plan = std::make_unique<FFT2Plan>(m, n);
+    }
+    return *plan;
+}
+
+
+/// @brief Real-input plan of the current thread for the shape (m, n), as fft2Plan.
+inline RealFFT2Plan& realFFT2Plan(Eigen::Index m, Eigen::Index n)
+{
+    thread_local std::unique_ptr<RealFFT2Plan> plan;
+    if (!plan || plan->rows() != m || plan->cols() != n)
+    {
+        plan = std::make_unique<RealFFT2Plan>(m, n);
+    }
+    return *plan;
+}
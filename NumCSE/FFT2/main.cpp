@@ -1,3 +1,4 @@
+#include <array>
 #include <cassert>
 #include <iostream>
 #include <complex>
@@ -7,47 +8,64 @@
 #include <Eigen/Dense>
 #include <unsupported/Eigen/FFT>
 
+#include "convolution.hpp"
+#include "fft2_plan.hpp"
+
 using namespace std;
 using namespace Eigen;  // includes Scalar, Matrix**, Vector**, fft, etc.
 
-// Implement FFT-2D on Eigen MatrixXd
+// Implement FFT-2D on Eigen MatrixXd, through the cached plan of the shape
 
-template<typename Scalar>
-void fft2(MatrixXcd& C, const MatrixBase<Scalar>& Y)
+// Half spectrum H = first m / 2 + 1 rows of fft2(Y) of a real Y, the rest follows by Hermitian symmetry
+void rfft2(MatrixXcd& H, const MatrixXd& Y)
 {
-    // Y_{m, n}
-    int m = Y.rows();
-    int n = Y.cols();
-
-    // C_{m, n}
-    C.resize(m, n);
-    MatrixXcd tmp(m, n);
+    realFFT2Plan(Y.rows(), Y.cols()).forward(Y, H);
+}
 
-    FFT<double> fft;
+// Real Y of m rows from its half spectrum H, which is overwritten
+void irfft2(MatrixXd& Y, MatrixXcd& H, int m)
+{
+    realFFT2Plan(m, H.cols()).inverse(H, Y);
+}
 
-    // FIXME: Something shady here
-    // Perform fft on rows of Y
-    for (int i = 0; i < m; i++)
+template<typename Scalar>
+void fft2(MatrixXcd& C, const MatrixBase<Scalar>& Y)
+{
+    if constexpr (!NumTraits<typename Scalar::Scalar>::IsComplex)
     {
-        tmp.row(i) = fft.fwd(((VectorXcd) Y.row(i))).transpose();
-        // fft.fwd(tmp.row(i), Y.row(i)); // Seems OK
+        // Real input: transform half the spectrum and mirror the rest
+        MatrixXcd H;
+        rfft2(H, Y.template cast<double>());
+        hermitianFullSpectrum(H, Y.rows(), C);
     }
-    // FIXME: Something shady here
-    // Perform fft on columns of tmp
-    for (int j = 0; j < n; j++)
+    else
     {
-        C.col(j) = fft.fwd(((VectorXcd) tmp.col(j)));
-        // fft.fwd(C.col(j), tmp.col(j));
+        C = Y.template cast<complex<double>>();
+        fft2Plan(C.rows(), C.cols()).forward(C);
     }
 }
 
 template<typename Scalar>
 void ifft2(MatrixXcd& C, const MatrixBase<Scalar>& Y)
 {
-    int m = Y.rows();
-    int n = Y.cols();
-    fft2(C, Y.conjugate());
-    C = C.conjugate() / (m * n);
+    if constexpr (!NumTraits<typename Scalar::Scalar>::IsComplex)
+    {
+        // Real input: ifft2(Y) = conj(fft2(Y)) / (m n)
+        fft2(C, Y);
+        C = C.conjugate() / double(Y.rows() * Y.cols());
+    }
+    else
+    {
+        C = Y.template cast<complex<double>>();
+        fft2Plan(C.rows(), C.cols()).inverse(C);
+    }
+}
+
+// Real operands: direct sum, overlap-save or one FFT, whichever the cost model of convolution.hpp expects to be
+// fastest for the sizes
+void conv2(MatrixXd& LHS, const MatrixXd& RHS1, const MatrixXd& RHS2)
+{
+    convolve(RHS1, RHS2, LHS);
 }
 
 void conv2(MatrixXcd& LHS, MatrixXcd& RHS1, MatrixXcd& RHS2)
@@ -61,18 +79,70 @@ void conv2(MatrixXcd& LHS, MatrixXcd& RHS1, MatrixXcd& RHS2)
     int n = n1 + n2 - 1;
     int m = m1 + m2 - 1;
 
-    MatrixXcd tmp1    = MatrixXcd::Zero(n, m);
-    MatrixXcd tmp2    = MatrixXcd::Zero(n, m);
-    MatrixXcd extRHS1 = MatrixXcd::Zero(n, m);
-    MatrixXcd extRHS2 = MatrixXcd::Zero(n, m);
+    // Purely real operands, like images and filter kernels, take the real path
+    if (RHS1.imag().isZero(0) && RHS2.imag().isZero(0))
+    {
+        MatrixXd realLHS;
+        conv2(realLHS, RHS1.real(), RHS2.real());
+        LHS = realLHS.cast<complex<double>>();
+        return;
+    }
+
+    // Small kernels: the direct sum, with the smaller operand as the kernel
+    const bool kernelFirst = RHS1.size() < RHS2.size();
+    const MatrixXcd& image  = kernelFirst ? RHS2 : RHS1;
+    const MatrixXcd& kernel = kernelFirst ? RHS1 : RHS2;
+    if (convolutionCost(image.rows(), image.cols(), kernel.rows(), kernel.cols()).cheapest() ==
+        ConvolutionAlgorithm::Direct)
+    {
+        convolveDirect(image, kernel, LHS);
+        return;
+    }
+
+    // Padded to the next 2-3-5 smooth sizes, where the FFT is fast; the result is the top left (n, m) corner
+    MatrixXcd extRHS1 = MatrixXcd::Zero(fastFFTSize(n), fastFFTSize(m));
+    MatrixXcd extRHS2 = MatrixXcd::Zero(fastFFTSize(n), fastFFTSize(m));
 
     extRHS1.topLeftCorner(n1, m1) = RHS1;
     extRHS2.topLeftCorner(n2, m2) = RHS2;
 
-    fft2(tmp1, extRHS1);
-    fft2(tmp2, extRHS2);
+    // One plan for both operands and the product, all transformed in place
+    FFT2Plan& plan = fft2Plan(extRHS1.rows(), extRHS1.cols());
+    plan.forward(extRHS1);
+    plan.forward(extRHS2);
+    extRHS1.array() *= extRHS2.array();
+    plan.inverse(extRHS1);
+    LHS = extRHS1.topLeftCorner(n, m);
+}
+
+// Reference: the convolution sum of the same (n1 + n2 - 1, m1 + m2 - 1) size
+MatrixXcd conv2Direct(const MatrixXcd& RHS1, const MatrixXcd& RHS2)
+{
+    MatrixXcd LHS = MatrixXcd::Zero(RHS1.rows() + RHS2.rows() - 1, RHS1.cols() + RHS2.cols() - 1);
+    for (int j = 0; j < RHS2.cols(); j++)
+    {
+        for (int i = 0; i < RHS2.rows(); i++)
+        {
+            LHS.block(i, j, RHS1.rows(), RHS1.cols()) += RHS2(i, j) * RHS1;
+        }
+    }
+    return LHS;
+}
 
-    ifft2(LHS, tmp1.cwiseProduct(tmp2));
+// Reference: 1D FFTs of the rows, then of the columns, each line copied to a vector
+MatrixXcd fft2Reference(const MatrixXcd& Y)
+{
+    FFT<double> fft;
+    MatrixXcd   C(Y.rows(), Y.cols());
+    for (int i = 0; i < Y.rows(); i++)
+    {
+        C.row(i) = fft.fwd(VectorXcd(Y.row(i).transpose())).transpose();
+    }
+    for (int j = 0; j < Y.cols(); j++)
+    {
+        C.col(j) = fft.fwd(VectorXcd(C.col(j)));
+    }
+    return C;
 }
 
 int main()
@@ -90,15 +160,113 @@ int main()
     MatrixXcd D(3, 3);
     ifft2(D, Y);
     cout << "Matrix D = ifft2(Y)\n" << D << "\n\n";
+    assert((D - C).norm() < 1e-12 * C.norm());
+
+    // Plan against the line-by-line reference, for shapes with mixed radices and larger than a transpose tile,
+    // twice per shape so the second call reuses the plan
+    for (auto [rows, cols] : {pair{48, 35}, pair{35, 48}, pair{2, 7}, pair{100, 64}})
+    {
+        const MatrixXcd R = MatrixXcd::Random(rows, cols);
+        for (int repeat = 0; repeat < 2; repeat++)
+        {
+            MatrixXcd F, G;
+            fft2(F, R);
+            assert((F - fft2Reference(R)).norm() < 1e-12 * F.norm());
+            ifft2(G, F);
+            assert((G - R).norm() < 1e-12 * R.norm());
+
+            // Real input through the half spectrum, for even and odd numbers of rows
+            const MatrixXd X = R.real();
+            MatrixXcd      H;
+            MatrixXd       Z;
+            fft2(F, X);
+            assert((F - fft2Reference(X.cast<complex<double>>())).norm() < 1e-12 * F.norm());
+            ifft2(G, X);
+            assert((G - F.conjugate() / double(rows * cols)).norm() < 1e-12 * G.norm());
+            rfft2(H, X);
+            assert(H.rows() == rows / 2 + 1 && (H - F.topRows(rows / 2 + 1)).norm() < 1e-12 * H.norm());
+            irfft2(Z, H, rows);
+            assert((Z - X).norm() < 1e-12 * X.norm());
+        }
+    }
+    // A single row: the column FFTs of length 1 are the identity
+    const MatrixXcd row = MatrixXcd::Random(1, 7);
+    MatrixXcd       rowHat, rowBack;
+    fft2(rowHat, row);
+    ifft2(rowBack, rowHat);
+    assert((rowBack - row).norm() < 1e-12 * row.norm());
+    const MatrixXd realRow = row.real();
+    MatrixXd       realRowBack;
+    rfft2(rowHat, realRow);
+    irfft2(realRowBack, rowHat, 1);
+    assert((realRowBack - realRow).norm() < 1e-12 * realRow.norm());
+
+    // Several threads split the lines and tiles but compute every line the same way, so the result is identical
+    MatrixXcd S = MatrixXcd::Random(300, 200), P = S;
+    FFT2Plan(300, 200, 1).forward(S);
+    FFT2Plan(300, 200, 3).forward(P);
+    assert(P == S);
+    MatrixXd  realS = MatrixXd::Random(301, 200), realP;
+    MatrixXcd halfS, halfP;
+    RealFFT2Plan(301, 200, 1).forward(realS, halfS);
+    RealFFT2Plan(301, 200, 3).forward(realS, halfP);
+    assert(halfP == halfS);
+    RealFFT2Plan(301, 200, 3).inverse(halfP, realP);
+    assert((realP - realS).norm() < 1e-12 * realS.norm());
+
+    // Complex operands keep the complex path
+    MatrixXcd A = MatrixXcd::Random(6, 9), B = MatrixXcd::Random(4, 3), AconvB;
+    conv2(AconvB, A, B);
+    assert((AconvB - conv2Direct(A, B)).norm() < 1e-12 * AconvB.norm());
+    MatrixXcd G = MatrixXcd::Random(40, 30), K = MatrixXcd::Random(35, 25), GconvK;
+    conv2(GconvK, G, K);
+    assert((GconvK - conv2Direct(G, K)).norm() < 1e-12 * GconvK.norm());
+
+    // Every algorithm of the convolution engine, on image and kernel shapes that leave partial tiles, with the
+    // kernel first or second and a single-row kernel
+    const vector<array<int, 4>> shapes = {{50, 70, 3, 3}, {97, 61, 17, 9}, {9, 17, 97, 61}, {64, 64, 1, 5},
+                                          {130, 90, 31, 40}, {5, 4, 5, 4}};
+    for (const auto& [n1, m1, k1, k2] : shapes)
+    {
+        const MatrixXd image = MatrixXd::Random(n1, m1), kernel = MatrixXd::Random(k1, k2);
+        const MatrixXd reference = conv2Direct(image.cast<complex<double>>(), kernel.cast<complex<double>>()).real();
+        for (ConvolutionAlgorithm algorithm : {ConvolutionAlgorithm::Direct, ConvolutionAlgorithm::OverlapSave,
+                                               ConvolutionAlgorithm::FFT, ConvolutionAlgorithm::Automatic})
+        {
+            MatrixXd result;
+            convolve(image, kernel, result, algorithm);
+            assert((result - reference).norm() < 1e-12 * reference.norm());
+        }
+    }
+    // A prepared filter convolves several frames with one kernel spectrum, at smooth sizes: 29 x 79 pads to 30 x 80
+    const MatrixXd  blur = MatrixXd::Random(5, 7);
+    PreparedFilter filter(blur, 25, 73);
+    assert(filter.fftRows() == 30 && filter.fftCols() == 80);
+    for (int frame = 0; frame < 3; frame++)
+    {
+        const MatrixXd image = MatrixXd::Random(25, 73);
+        MatrixXd       result;
+        filter.apply(image, result);
+        const MatrixXd reference = conv2Direct(image.cast<complex<double>>(), blur.cast<complex<double>>()).real();
+        assert((result - reference).norm() < 1e-12 * reference.norm());
+    }
+    // The cost model: a 3x3 filter on a large image is summed directly, a medium one tiled, a large one by one FFT
+    // where the full size, here 1024, has only small prime factors
+    assert(convolutionCost(2000, 2000, 3, 3).cheapest() == ConvolutionAlgorithm::Direct);
+    assert(convolutionCost(2000, 2000, 31, 31).cheapest() == ConvolutionAlgorithm::OverlapSave);
+    assert(convolutionCost(625, 625, 400, 400).cheapest() == ConvolutionAlgorithm::FFT);
 
 
     // Test convolution
     MatrixXcd F(3, 3);
     F << 0, -1, 0, -1, 4, -1, 0, -1, 0;
 
+    // F and the logo below are real, so conv2 takes the real path, where the 3x3 kernel is summed directly
     MatrixXcd FconvF = MatrixXcd::Zero(3, 3);
     conv2(FconvF, F, F);
-    MatrixXi outFconvF = FconvF.real().cast<int>();
+    assert((FconvF - conv2Direct(F, F)).norm() < 1e-12 * FconvF.norm());
+    // Rounded, a plain cast truncates values like 0.9999999999 to 0
+    MatrixXi outFconvF = FconvF.real().array().round().cast<int>();
     cout << "conv(F,F) casted to real ints\n" << outFconvF << "\n\n";
 
 
@@ -132,36 +300,37 @@ int main()
 
     MatrixXcd conv = MatrixXcd::Zero(25, 77);
     conv2(conv, logoETH, F);
-    MatrixXi outlogoETH = conv.real().cast<int>();
+    assert((conv - conv2Direct(logoETH, F)).norm() < 1e-12 * conv.norm());
+    MatrixXi outlogoETH = conv.real().array().round().cast<int>();
     cout << outlogoETH << endl;
 
     // Expected:
     // 0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0
-    // 0  0  0  0  0  0  0  0 -1 -1 -1 -1  0 -1 -1  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0 -1  0 -1 -1  0 -1 -1  0 -1 -1 -1  0 -1  0  0 -1 -1 -1 -1 -1  0 -1 -1 -1 -1 -1  0  0 -1  0  0  0  0  0  0  0  0  0  0  0 -1 -1  0 -1 -1 -1  0  0  0  0
-    // 0  0  0  0  0  0  0  0  2  1  1  1  1  1  1  1  1  0  1  1  1  0  1  1  1  1  1  0  1  1  1  1  0  1  1  1  1  1  1  1  1  1  1  1  0  1  1  1  1  0  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0 -1  2  0  0  1  1  1  1  2 -1  0  0
-    // 0  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -2  0  0  0  0  0  0  0  2 -1  0  0
-    // 0  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0 -2  2  0  0  0  0  0  0  1 -2  0  0  0
-    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -1  0  0  0  0 -1  2  0  0  0  0  0  0  0  1  0  0  0  0
-    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  1  0  0  1  1  1  1  1  1  1  1  1  0  0  0  1  0  0  0  0  0  0  0  0  1  1  1  1  1  1  1  0  0  0  0  0  0  0  0  1 -1  0  0  0  0 -1  1  0  0  0  0  0  0  0  2 -1  0  0  0
-    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  1 -2  0  0  0 -1  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0 -1 -2  1  0  0  0  0  0  0  0 -2 -1 -1 -1 -1 -1 -1 -2  0  0  0  0  0  0  0  1  0  0  0  0  0 -1  1  0  0  0  0  0  0  0 -2  0  0  0  0
-    // 0  0  0  0  0  0 -2  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  0 -1  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  2  0  0  0  0  0 -1  0  0  0  0  0  0  0  0 -1  0  0  0  0
+    // 0  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0
+    // 0  0  0  0  0  0  0 -1  2  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0 -1  2  1  1  1  1  1  1  2 -1  0  0
+    // 0  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -2  1  0  0  0  0  0  0  2 -1  0  0
+    // 0  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0 -2  2  0  0  0  0  0  0  1 -2  0  0  0
+    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0 -1  2  0  0  0  0  0  0  0  1 -1  0  0  0
+    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  0  0  0  0  0  0  0  0  1  1  1  1  1  1  1  1  0  0  0  0  0  0  0  1 -1  0  0  0  0 -1  1  0  0  0  0  0  0  0  2 -1  0  0  0
+    // 0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -2  1  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -1 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0 -1  1  0  0  0  0  0  0  1 -2  0  0  0  0
+    // 0  0  0  0  0  0 -2  1  0  0  0  0  0  0  0  2 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  2 -1  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0
     // 0  0  0  0  0 -1  2  0  0  0  0  0  0  0  2 -2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -2  2  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -2  2  0  0  0  0  0  0  1 -2  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0
-    // 0  0  0  0  0 -1  0  0  0  0  0  0  0  0 -3  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  2  0  0  0  0  0  0  0  0 -2  0  0  0  0  0  0  2  0  0  0  0  0  0  0  1 -1 -1  0 -1  0 -1 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0
-    // 0  0  0  0  0  0  1  0  0  0  0  0  0  0  1  0  1  1  1  1  1  1  1  1  1  1  2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  2  0  0  0  0  0  0 -1  0  0  0  0  0  0  0  0  0  0  0  1  1  0  0  0  0  0  0  0  0  0  0  2  0  0  0  0  0
-    // 0  0  0  0  0 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2  0  0  0  0  0  0  0  1  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0
-    // 0  0  0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1  0  0  0  0  0  0  0 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0
-    // 0  0  0  0 -1  2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1  0  0  0  0  0  0  0  0  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0
-    // 0  0  0  0 -1  1  0  0  0  0  0  0  0  1  0  1  1  0  1  1  1  0  0  0  1  2 -1  0  0  0  0  0  0 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -2  0  0  0  0  0  0  0  1  1  1  1  1  0  1  0  0  0  0  0  0  0  1 -2  0  0  0  0  0  0
-    // 0  0  0  0 -1  1  0  0  0  0  0  0  0 -2 -1 -1 -1  0 -1 -1  0  0  0  0  0 -1  0  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  2  0  0  0  0  0  0  0 -2 -1 -1 -1 -1 -1 -2  1  0  0  0  0  0  0  0 -1  0  0  0  0  0  0
-    // 0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
-    // 0  0  0  0 -2  1  0  0  0  0  0  0  0 -2 -1 -1 -1 -1 -1 -1 -1 -1 -1  0 -1  0  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
-    // 0  0  0  0  2  0  0  0  0  0  0  0  0  1  1  1  1  1  0  1  1  1  1  1  2  0  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  2 -1  0  0  0  0  0  0 -2  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -2  1  0  0  0  0  0  0  0 -1  0  0  0  0  0  0
-    // 0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  0 -1  0  0  0  0  0  0
-    // 0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1  0  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0 -2  1  0  0  0  0  0  0  0  2 -1  0  0  0  0  0  0
+    // 0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -3 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  1 -2  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0
+    // 0  0  0  0  0 -1  1  0  0  0  0  0  0  0  1  1  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  1  1  1  1  1  1  1  0  0  0  0  0  0  0  2 -1  0  0  0  0
+    // 0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0
+    // 0  0  0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0
+    // 0  0  0  0 -1  2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0
+    // 0  0  0  0 -1  1  0  0  0  0  0  0  0  1  1  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  1  1  1  1  1  1  1  0  0  0  0  0  0  0  1 -2  0  0  0  0  0  0
+    // 0  0  0  0 -1  1  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
+    // 0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
+    // 0  0  0  0 -2  1  0  0  0  0  0  0  1 -2 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
+    // 0  0  0 -1  2  0  0  0  0  0  0  0  0  1  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  2 -1  0  0  0  0  0  0 -2  1  0  0  0  0  0  0  2 -1  0  0  0  0  0 -2  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
+    // 0  0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  2  0  0  0  0  0  0  1 -2  0  0  0  0  0 -1  2  0  0  0  0  0  0  0  1 -1  0  0  0  0  0  0
+    // 0  0  0 -2  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  2 -1  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0 -2  1  0  0  0  0  0  0  0  2 -1  0  0  0  0  0  0
     // 0  0 -1  2  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -2  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0 -1  2  0  0  0  0  0  0  0  2 -2  0  0  0  0  0  0  0
     // 0  0 -1  1  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0  0  0 -1  1  0  0  0  0  0  0  1 -1  0  0  0  0 -1  1  0  0  0  0  0  0  1 -2  0  0  0  0  0  0  0  0
-    // 0  0 -1  2  1  1  1  1  1  1  1  1  1  1  0  1  1  0  1  1  1  1  1  2 -1  0  0  0  0  0  0 -1  2  1  1  1  1  1  1  2 -1  0  0  0  0  0  0 -1  2  0  1  1  1  1  1  2 -1  0  0  0  0 -1  2  0  1  1  1  1  0  2 -1  0  0  0  0  0  0  0  0
-    // 0  0  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0 -1 -1  0 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0 -1  0 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0  0
+    // 0  0 -1  2  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  1  2 -1  0  0  0  0  0  0 -1  2  1  1  1  1  1  1  2 -1  0  0  0  0  0  0 -1  2  1  1  1  1  1  1  2 -1  0  0  0  0 -1  2  1  1  1  1  1  1  2 -1  0  0  0  0  0  0  0  0
+    // 0  0  0 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0 -1 -1 -1 -1 -1 -1 -1 -1  0  0  0  0  0  0  0  0  0
     // 0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0  0
 
     return 0;
@@ -0,0 +1,162 @@
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "benchmark_stats.hpp"
+#include "fft2_plan.hpp"
+
+using Eigen::Index;
+using Eigen::MatrixXcd;
+using Eigen::MatrixXd;
+using std::cout;
+using std::endl;
+using std::setw;
+using Complex = std::complex<double>;
+
+
+/// @brief Test image, cheap to recompute, so the round trip can be checked without keeping a copy.
+Complex pixel(Index i, Index j)
+{
+    return {std::cos(0.37 * i + 0.11 * j), std::sin(0.13 * i - 0.29 * j)};
+}
+
+
+/// @brief Thread counts of the strong-scaling runs: powers of two up to the OpenMP maximum, and the maximum.
+std::vector<int> threadCounts()
+{
+    const int        maxThreads = detail::threadCount(0);
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2)
+    {
+        counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+
+/// @brief Prints a line of the table: time per transform, speedup and parallel efficiency against one thread,
+/// and the rate in the usual 5 N log2(N) flop count of a complex FFT of N points.
+void report(const char* name, int threads, double seconds, double serial, double flops)
+{
+    cout << setw(10) << name << setw(9) << threads << setw(12) << seconds << setw(10) << serial / seconds << setw(12)
+         << serial / seconds / threads << setw(10) << flops / seconds * 1e-9 << endl;
+}
+
+
+/// @brief Strong scaling of a forward and an inverse 2D FFT of one (N, N) image over the thread counts.
+void scaling(Index N, int repetitions)
+{
+    const double points = double(N) * double(N);
+    cout << endl
+         << N << " x " << N << ": complex needs " << 2 * 16 * points / 1e9 << " GB (image and scratch), real "
+         << (8 + 3 * 8) * points / 1e9 << " GB (image, result, half spectrum and scratch)" << endl;
+    cout << setw(10) << "transform" << setw(9) << "threads" << setw(12) << "time [s]" << setw(10) << "speedup"
+         << setw(12) << "efficiency" << setw(10) << "GFLOP/s" << endl;
+
+    // Best of the given runs without a warmup, a round trip on the largest images takes seconds
+    BenchmarkOptions opts;
+    opts.warmup  = 0;
+    opts.minReps = repetitions;
+    opts.minTime = 0;
+
+    {
+        // Image first touched by the threads of the first column pass, the only pass its placement matches
+        FirstTouchBuffer<Complex> buffer(N, N);
+        Eigen::Map<MatrixXcd>     X(buffer.data(), N, N);
+        #pragma omp parallel for schedule(static)
+        for (Index j = 0; j < N; j++)
+        {
+            for (Index i = 0; i < N; i++)
+            {
+                X(i, j) = pixel(i, j);
+            }
+        }
+
+        double serial = 0;
+        for (int threads : threadCounts())
+        {
+            FFT2Plan     plan(N, N, threads);
+            const double t = measure([&] {
+                plan.forward(X);
+                plan.inverse(X);
+            }, opts).min / 2;
+            serial = threads == 1 ? t : serial;
+            report("c2c", threads, t, serial, 5 * points * std::log2(points));
+        }
+
+        double error = 0;
+        #pragma omp parallel for schedule(static) reduction(max : error)
+        for (Index j = 0; j < N; j++)
+        {
+            for (Index i = 0; i < N; i++)
+            {
+                error = std::max(error, std::abs(X(i, j) - pixel(i, j)));
+            }
+        }
+        cout << "largest round-trip error " << error << endl;
+    }
+
+    {
+        FirstTouchBuffer<double> buffer(N, N);
+        Eigen::Map<MatrixXd>     X(buffer.data(), N, N);
+        #pragma omp parallel for schedule(static)
+        for (Index j = 0; j < N; j++)
+        {
+            for (Index i = 0; i < N; i++)
+            {
+                X(i, j) = pixel(i, j).real();
+            }
+        }
+
+        MatrixXcd H;
+        MatrixXd  Z;
+        double    serial = 0;
+        for (int threads : threadCounts())
+        {
+            RealFFT2Plan plan(N, N, threads);
+            const double t = measure([&] {
+                plan.forward(X, H);
+                plan.inverse(H, Z);
+            }, opts).min / 2;
+            serial = threads == 1 ? t : serial;
+            // Half the flops of the complex transform of the same size
+            report("r2c/c2r", threads, t, serial, 2.5 * points * std::log2(points));
+        }
+        cout << "largest round-trip error " << (Z - X).cwiseAbs().maxCoeff() << endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    // The 4K x 4K image takes 0.5 GB as complex numbers and 16K x 16K takes 8.6 GB with the scratch, so the
+    // default stops at 8K x 8K and larger sizes go on the command line: scaling_benchmark 4096 16384
+    std::vector<Index> sizes;
+    for (int a = 1; a < argc; a++)
+    {
+        sizes.push_back(std::atol(argv[a]));
+    }
+    if (sizes.empty())
+    {
+        sizes = {4096, 8192};
+    }
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl;
+#endif
+    cout << "Strong scaling of the 2D FFT, time per transform, best of 2 forward-inverse round trips" << endl;
+
+    for (Index N : sizes)
+    {
+        scaling(N, 2);
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+
+/// @brief Repetition policy of a measurement: the warmup runs are discarded, then the function is
+/// repeated until both minReps and minTime are reached, or maxReps.
+struct BenchmarkOptions
+{
+    int    warmup  = 2;
+    int    minReps = 5;
+    int    maxReps = 100;
+    double minTime = 0.2;  // seconds
+};
+
+
+/// @brief Summary statistics of a set of timing samples, in seconds.
+struct TimingStats
+{
+    int    reps   = 0;
+    double min    = 0;
+    double p10    = 0;
+    double median = 0;
+    double p90    = 0;
+    double max    = 0;
+    double mean   = 0;
+    double stddev = 0;
+};
+
+
+/// @brief Linear interpolation percentile of sorted samples.
+/// @param sorted are the samples in increasing order.
+/// @param p is the percentile in [0, 100].
+/// @return The percentile.
+inline double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    const double pos = p / 100.0 * static_cast<double>(sorted.size() - 1);
+    const size_t lo  = static_cast<size_t>(pos);
+    const size_t hi  = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (pos - static_cast<double>(lo)) * (sorted[hi] - sorted[lo]);
+}
+
+
+/// @brief Computes the summary statistics of timing samples.
+/// @param samples are the samples, reordered on exit.
+/// @return The statistics.
+inline TimingStats summarize(std::vector<double>& samples)
+{
+    TimingStats s;
+    s.reps = static_cast<int>(samples.size());
+    if (samples.empty())
+    {
+        return s;
+    }
+    std::sort(samples.begin(), samples.end());
+    s.min    = samples.front();
+    s.max    = samples.back();
+    s.p10    = percentile(samples, 10);
+    s.median = percentile(samples, 50);
+    s.p90    = percentile(samples, 90);
+    double sum = 0;
+    for (double t : samples)
+    {
+        sum += t;
+    }
+    s.mean = sum / s.reps;
+    double var = 0;
+    for (double t : samples)
+    {
+        var += (t - s.mean) * (t - s.mean);
+    }
+    s.stddev = s.reps > 1 ? std::sqrt(var / (s.reps - 1)) : 0;
+    return s;
+}
+
+
+/// @brief Times a function under a repetition policy.
+/// @param func is the function to be measured.
+/// @param opts is the repetition policy.
+/// @param setup is called untimed before every run, e.g. to restore the input of an in-place kernel.
+/// @return The statistics of the timed runs.
+template<typename Func, typename Setup>
+TimingStats measure(Func&& func, const BenchmarkOptions& opts, Setup&& setup)
+{
+    using Clock = std::chrono::steady_clock;
+
+    for (int i = 0; i < opts.warmup; i++)
+    {
+        setup();
+        func();
+    }
+    std::vector<double> samples;
+    double              total = 0;
+    while (static_cast<int>(samples.size()) < opts.maxReps
+           && (static_cast<int>(samples.size()) < opts.minReps || total < opts.minTime))
+    {
+        setup();
+        const Clock::time_point start = Clock::now();
+        func();
+        const double t = std::chrono::duration<double>(Clock::now() - start).count();
+        samples.push_back(t);
+        total += t;
+    }
+    return summarize(samples);
+}
+
+/// @brief Times a function that needs no setup between runs.
+template<typename Func>
+TimingStats measure(Func&& func, const BenchmarkOptions& opts = BenchmarkOptions())
+{
+    return measure(std::forward<Func>(func), opts, [] {});
+}
+
+
+/// @brief Tracks the resident memory high-water mark of the process. On Linux the kernel mark is
+/// reset at start(), so peak() is the high-water mark of the measured section; elsewhere the mark of
+/// getrusage only grows, and sections that stay below an earlier peak report it. Freed heap memory is
+/// returned to the system first where glibc allows it, so reused pages count as growth again.
+class MemoryHighWater
+{
+  public:
+    /// @brief Resets the high-water mark to the current resident size and remembers that size.
+    void start()
+    {
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+#ifdef __linux__
+        std::ofstream("/proc/self/clear_refs") << "5";
+        baseline = readStatus("VmRSS:");
+#else
+        baseline = maxRSS();
+#endif
+    }
+
+    /// @return The high-water mark since start(), in bytes.
+    double peak() const
+    {
+#ifdef __linux__
+        const double hwm = readStatus("VmHWM:");
+        if (hwm > 0)
+        {
+            return hwm;
+        }
+#endif
+        return maxRSS();
+    }
+
+    /// @return The growth of the high-water mark over the resident size at start(), in bytes.
+    double growth() const { return std::max(0.0, peak() - baseline); }
+
+  private:
+    double baseline = 0;
+
+    static double maxRSS()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<double>(usage.ru_maxrss);  // bytes
+#else
+        return 1024.0 * static_cast<double>(usage.ru_maxrss);  // kilobytes
+#endif
+    }
+
+#ifdef __linux__
+    static double readStatus(const std::string& key)
+    {
+        std::ifstream in("/proc/self/status");
+        std::string   line;
+        while (std::getline(in, line))
+        {
+            if (line.compare(0, key.size(), key) == 0)
+            {
+                return 1024.0 * std::stod(line.substr(key.size()));  // kilobytes
+            }
+        }
+        return 0;
+    }
+#endif
+};
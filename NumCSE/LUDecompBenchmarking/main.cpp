@@ -1,90 +1,257 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <Eigen/Eigen>
 
-#define TimeNow std::chrono::high_resolution_clock::now
-#define TimeVar std::chrono::time_point<std::chrono::high_resolution_clock>
+#include "benchmark_stats.hpp"
+#include "tridiagonal.hpp"
 
 using std::cout;
 using std::endl;
+using std::setw;
+using std::string;
 using std::vector;
+using Eigen::Index;
 using Eigen::Triplet;
-using std::function;
-using std::chrono::duration;
+using Eigen::VectorXd;
 
 
 /// @brief Function that makes the triplet list for a tridiagonal matrix
 /// @param n is the size of the matrix
 /// @return the triplet list
-vector<Triplet<double>> makeTripletList(int n){
+vector<Triplet<double>> makeTripletList(Index n)
+{
     // Make triplet list for tridiagonal matrix
-    int nnz = 3 * n - 2;
+    Index nnz = 3 * n - 2;
     vector<Triplet<double>> tripletList;
     tripletList.reserve(nnz);
-    for (int i = 0; i < n - 1; ++i){
-        tripletList.push_back(Triplet<double>(i, i + 1, -1.0)); // lower diagonal entry
-        tripletList.push_back(Triplet<double>(i, i, 2.0)); // diagonal entry
-        tripletList.push_back(Triplet<double>(i + 1, i, -1.0)); // upper diagonal entry
+    for (Index i = 0; i < n - 1; ++i)
+    {
+        tripletList.push_back(Triplet<double>(i, i + 1, -1.0));  // upper diagonal entry
+        tripletList.push_back(Triplet<double>(i, i, 2.0));       // diagonal entry
+        tripletList.push_back(Triplet<double>(i + 1, i, -1.0));  // lower diagonal entry
     }
-    tripletList.push_back(Triplet<double>(n - 1, n - 1, 2.0)); // last diagonal entry
+    tripletList.push_back(Triplet<double>(n - 1, n - 1, 2.0));  // last diagonal entry
     return tripletList;
 }
 
 
-/// @brief Function to measure runtime of a function
-/// @param func is the function to be measured
-/// @return The average runtime of the function (10 reps.)
-double runTime(const function<void(void)> &func){
-    TimeVar start, end;
-    int reps = 10; // number of repetitions
-    double sum = 0.0; // sum of runtimes
+/// @brief One measured solver at one size.
+struct BenchmarkResult
+{
+    string      solver;
+    Index       n = 0;
+    TimingStats factor;
+    TimingStats solve;
+    double      memory   = 0;  // growth of the resident high-water mark, bytes
+    double      backward = 0;  // normwise backward error of the solution
+};
 
-    for (int i = 0; i < reps; ++i){
-        start = TimeNow();
-        func();
-        end = TimeNow();
-        sum += duration<double>(end - start).count();
+
+/// @brief A solver under test: it sets itself up for the size n and returns closures for the
+/// factorization and the solve, the latter writing its solution into x.
+struct SolverCase
+{
+    struct Runs
+    {
+        std::function<void()> factor;
+        std::function<void()> solve;
+    };
+
+    string                                                                           name;
+    Index                                                                            maxN;
+    std::function<Runs(const Eigen::SparseMatrix<double>&, const VectorXd&, VectorXd&)> setup;
+};
+
+
+/// @brief Makes a case for an Eigen solver that factorizes a matrix of type Matrix.
+template<typename Solver, typename Matrix>
+SolverCase eigenCase(const string& name, Index maxN)
+{
+    return {name, maxN, [](const Eigen::SparseMatrix<double>& A, const VectorXd& b, VectorXd& x) {
+                auto matrix = std::make_shared<Matrix>(A);
+                auto solver = std::make_shared<Solver>();
+                return SolverCase::Runs{[=] { solver->compute(*matrix); }, [=, &b, &x] { x = solver->solve(b); }};
+            }};
+}
+
+
+/// @brief The three diagonals of the matrix, shared by the closures of a tridiagonal case.
+struct TridiagonalMatrix
+{
+    VectorXd a, b, c;
+};
+using Diagonals = std::shared_ptr<const TridiagonalMatrix>;
+
+/// @brief Makes a case for a solver from the tridiagonal module, which gets the diagonals instead of the matrix.
+template<typename Make>
+SolverCase tridiagonalCase(const string& name, Make make)
+{
+    return {name, 10000000, [make](const Eigen::SparseMatrix<double>& A, const VectorXd& b, VectorXd& x) {
+                const Index n = A.rows();
+                auto        m = std::make_shared<TridiagonalMatrix>();
+                m->a.resize(n - 1);
+                m->b = A.diagonal();
+                m->c.resize(n - 1);
+                for (Index i = 0; i < n - 1; i++)
+                {
+                    m->a(i) = A.coeff(i + 1, i);
+                    m->c(i) = A.coeff(i, i + 1);
+                }
+                return make(Diagonals(m), b, x);
+            }};
+}
+
+
+/// @brief Normwise backward error |A x - b| / (|A| |x| + |b|) in the infinity norm.
+double backwardError(const Eigen::SparseMatrix<double>& A, const VectorXd& x, const VectorXd& b)
+{
+    const double normA = (A.cwiseAbs() * VectorXd::Ones(A.cols())).maxCoeff();  // largest absolute row sum
+    return (A * x - b).lpNorm<Eigen::Infinity>() / (normA * x.lpNorm<Eigen::Infinity>() + b.lpNorm<Eigen::Infinity>());
+}
+
+
+/// @brief Writes the results as CSV, one line per solver and size.
+void writeCSV(const string& path, const vector<BenchmarkResult>& results)
+{
+    std::ofstream out(path);
+    out << "solver,n,factor_reps,factor_median,factor_p10,factor_p90,factor_stddev,"
+           "solve_reps,solve_median,solve_p10,solve_p90,solve_stddev,memory_bytes,backward_error\n";
+    for (const BenchmarkResult& r : results)
+    {
+        out << r.solver << ',' << r.n << ',' << r.factor.reps << ',' << r.factor.median << ',' << r.factor.p10 << ','
+            << r.factor.p90 << ',' << r.factor.stddev << ',' << r.solve.reps << ',' << r.solve.median << ','
+            << r.solve.p10 << ',' << r.solve.p90 << ',' << r.solve.stddev << ',' << r.memory << ',' << r.backward
+            << '\n';
+    }
+}
+
+
+/// @brief Writes the results as a JSON array.
+void writeJSON(const string& path, const vector<BenchmarkResult>& results)
+{
+    auto stats = [](std::ofstream& out, const TimingStats& s) {
+        out << "{\"reps\": " << s.reps << ", \"min\": " << s.min << ", \"p10\": " << s.p10
+            << ", \"median\": " << s.median << ", \"p90\": " << s.p90 << ", \"max\": " << s.max
+            << ", \"mean\": " << s.mean << ", \"stddev\": " << s.stddev << "}";
+    };
+    std::ofstream out(path);
+    out << "[";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        out << (i ? ",\n  " : "\n  ") << "{\"solver\": \"" << r.solver << "\", \"n\": " << r.n << ", \"factor\": ";
+        stats(out, r.factor);
+        out << ", \"solve\": ";
+        stats(out, r.solve);
+        out << ", \"memory_bytes\": " << r.memory << ", \"backward_error\": " << r.backward << "}";
     }
-    return sum / reps;
+    out << "\n]\n";
 }
 
 
-int main(){
+int main(int argc, char* argv[])
+{
+    // The largest size can be lowered from the command line for quick runs
+    const Index maxN = argc > 1 ? std::atol(argv[1]) : 10000000;
+
     // Initialize matrix sizes
-    vector<int> nList = {16, 32, 64, 128, 256, 512};
-    cout << "LU decomposition of tridiagonal matrix" << endl;
-    cout << "=======================================" << endl;
-    cout << "n" << "\t\t" << "SparseLU time (s)" << "\t" << "DenseLU time (s)" << endl;
+    vector<Index> nList;
+    for (Index n : {16, 64, 256, 1024, 2048, 4096, 16384, 100000, 1000000, 10000000})
+    {
+        if (n <= maxN)
+        {
+            nList.push_back(n);
+        }
+    }
 
-    vector<double> timeSparse;
-    vector<double> timeDense;
+    // Dense factorizations are cut off where their O(n^2) memory and O(n^3) time stop being useful
+    vector<SolverCase> cases = {
+        eigenCase<Eigen::SparseLU<Eigen::SparseMatrix<double>>, Eigen::SparseMatrix<double>>("SparseLU", 1000000),
+        eigenCase<Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>>, Eigen::SparseMatrix<double>>("SimplicialLDLT", 10000000),
+        eigenCase<Eigen::PartialPivLU<Eigen::MatrixXd>, Eigen::MatrixXd>("PartialPivLU", 2048),
+        eigenCase<Eigen::FullPivLU<Eigen::MatrixXd>, Eigen::MatrixXd>("FullPivLU", 1024),
+        tridiagonalCase("Thomas", [](const Diagonals& m, const VectorXd& b, VectorXd& x) {
+            auto solver = std::make_shared<ThomasSolver<double>>();
+            return SolverCase::Runs{[=] { solver->compute(m->a, m->b, m->c); }, [=, &b, &x] { x = b; solver->solveInPlace(x); }};
+        }),
+        // The two parallel methods have no separate factorization, the whole solve is timed as the solve
+        tridiagonalCase("CyclicReduction", [](const Diagonals& m, const VectorXd& b, VectorXd& x) {
+            return SolverCase::Runs{[] {}, [=, &b, &x] { x = b; cyclicReductionSolve(m->a, m->b, m->c, x); }};
+        }),
+        tridiagonalCase("Partition", [](const Diagonals& m, const VectorXd& b, VectorXd& x) {
+            return SolverCase::Runs{[] {}, [=, &b, &x] { x = b; partitionSolve(m->a, m->b, m->c, x); }};
+        }),
+    };
 
-    for (int n : nList) {
-        auto tripletList = makeTripletList(n);
+    cout << "Direct solvers on the tridiagonal (-1, 2, -1) matrix" << endl;
+    cout << "====================================================" << endl;
+    cout << "times are the median [p10, p90] over the repetitions, memory the high-water growth" << endl;
+    cout << setw(16) << "solver" << setw(10) << "n" << setw(34) << "factor time (s)" << setw(34) << "solve time (s)"
+         << setw(12) << "memory (MB)" << setw(12) << "backward" << endl;
 
+    vector<BenchmarkResult> results;
+    MemoryHighWater         memory;
+    for (Index n : nList)
+    {
         // Sparse matrix
+        auto                        tripletList = makeTripletList(n);
         Eigen::SparseMatrix<double> A(n, n);
         A.setFromTriplets(tripletList.begin(), tripletList.end());
+        tripletList = vector<Triplet<double>>();
+        const VectorXd b = VectorXd::Ones(n);
+        VectorXd       x;
 
-        Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
-        function<void(void)> funcSparse = [&](){solver.compute(A);};
+        // Large sizes take seconds per run, so they get fewer repetitions
+        BenchmarkOptions opts;
+        if (n >= 1000000)
+        {
+            opts.warmup  = 1;
+            opts.minReps = 3;
+            opts.minTime = 0;
+        }
 
-        // Dense matrix
-        Eigen::MatrixXd B(A);
-        Eigen::FullPivLU<Eigen::MatrixXd> solverDense;
-        function<void(void)> funcDense = [&](){solverDense.compute(B);};
+        for (const SolverCase& c : cases)
+        {
+            if (n > c.maxN)
+            {
+                continue;
+            }
+            BenchmarkResult r;
+            r.solver = c.name;
+            r.n      = n;
+            memory.start();
+            {
+                SolverCase::Runs runs = c.setup(A, b, x);
+                r.factor              = measure(runs.factor, opts);
+                r.solve               = measure(runs.solve, opts);
+            }
+            r.memory   = memory.growth();
+            r.backward = backwardError(A, x, b);
+            assert(r.backward < 1e-12);
+            results.push_back(r);
 
-        // Measure runtime
-        timeSparse.push_back(runTime(funcSparse));
-        timeDense.push_back(runTime(funcDense));
-    }
-
-    // Print results
-    for (int i = 0; i < nList.size(); ++i){
-        cout << nList[i] << "\t\t" << timeSparse[i] << "\t\t" << timeDense[i] << endl;
+            auto cell = [](const TimingStats& s) {
+                std::ostringstream os;
+                os << std::setprecision(3) << s.median << " [" << s.p10 << ", " << s.p90 << "]";
+                return os.str();
+            };
+            cout << setw(16) << r.solver << setw(10) << n << setw(34) << cell(r.factor) << setw(34) << cell(r.solve)
+                 << setw(12) << std::setprecision(3) << r.memory / 1e6 << setw(12) << r.backward << endl;
+        }
     }
 
+    writeCSV("lu_benchmark.csv", results);
+    writeJSON("lu_benchmark.json", results);
+    cout << "Results written to lu_benchmark.csv and lu_benchmark.json" << endl;
 
     return 0;
-}
\ No newline at end of file
+}
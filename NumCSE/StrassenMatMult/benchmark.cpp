@@ -0,0 +1,88 @@
+#include <iomanip>
+#include <iostream>
+#include <Eigen/Dense>
+#include <omp.h>
+
+#include "benchmark_stats.hpp"
+#include "gemm.hpp"
+#include "strassen.hpp"
+
+using Eigen::MatrixXf;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+int main(int argc, char* argv[])
+{
+    const int maxN = argc > 1 ? std::atoi(argv[1]) : 4096;
+
+    // Best of three runs without a warmup, a product of the larger sizes takes seconds
+    BenchmarkOptions opts;
+    opts.warmup  = 0;
+    opts.minReps = 3;
+    opts.minTime = 0;
+
+    // Cutoff sweep at a fixed size
+    {
+        const int N = std::min(2048, maxN);
+        MatrixXf  A = MatrixXf::Random(N, N), B = MatrixXf::Random(N, N), C;
+        double    tEigen = measure([&] { C.noalias() = A * B; }, opts).min;
+        cout << "Cutoff sweep, N = " << N << ", Eigen " << tEigen << " s" << endl;
+        cout << setw(8) << "cutoff" << setw(12) << "time [s]" << setw(12) << "speedup" << endl;
+        StrassenWorkspace<float> ws;
+        for (Eigen::Index cutoff : {64, 128, 256, 512, 1024})
+        {
+            double t = measure([&] { strassenMultInPlace(A, B, C, ws, cutoff); }, opts).min;
+            cout << setw(8) << cutoff << setw(12) << t << setw(12) << tEigen / t << endl;
+        }
+    }
+
+    // Leaf kernel: Eigen's GEMM or the in-house blocked GEMM
+    {
+        const int                N = std::min(2048, maxN);
+        MatrixXf                 A = MatrixXf::Random(N, N), B = MatrixXf::Random(N, N), C;
+        StrassenWorkspace<float> ws;
+        double tEigenLeaf   = measure([&] { strassenMultInPlace(A, B, C, ws); }, opts).min;
+        double tBlockedLeaf = measure([&] { strassenMultInPlace(A, B, C, ws, kStrassenCutoff, BlockedGemmLeaf()); }, opts).min;
+        cout << endl << "Leaf kernel, N = " << N << " : Eigen " << tEigenLeaf << " s, blocked GEMM " << tBlockedLeaf << " s" << endl;
+    }
+
+    // Sizes, including odd ones that are peeled, with the default cutoff
+    cout << endl << setw(8) << "N" << setw(12) << "Eigen [s]" << setw(14) << "Strassen [s]" << setw(12) << "speedup" << setw(12) << "rel. error" << endl;
+    StrassenWorkspace<float> ws;
+    for (int N : {512, 1024, 1500, 2048, 3001, 4096})
+    {
+        if (N > maxN)
+        {
+            break;
+        }
+        MatrixXf A = MatrixXf::Random(N, N), B = MatrixXf::Random(N, N), C, S;
+        BenchmarkOptions sized = opts;
+        sized.minReps          = N > 2048 ? 1 : 3;
+        double tEigen          = measure([&] { C.noalias() = A * B; }, sized).min;
+        double tStrassen       = measure([&] { strassenMultInPlace(A, B, S, ws); }, sized).min;
+        cout << setw(8) << N << setw(12) << tEigen << setw(14) << tStrassen << setw(12) << tEigen / tStrassen << setw(12)
+             << (S - C).norm() / C.norm() << endl;
+    }
+
+    // Thread scaling of the task-parallel Strassen against Eigen's multithreaded GEMM
+    {
+        const int maxThreads = omp_get_max_threads();
+        const int N          = std::min(2048, maxN);
+        MatrixXf  A = MatrixXf::Random(N, N), B = MatrixXf::Random(N, N), C, S;
+        cout << endl << "Thread scaling, N = " << N << endl;
+        cout << setw(8) << "threads" << setw(12) << "Eigen [s]" << setw(14) << "depth 1 [s]" << setw(14) << "depth 2 [s]" << endl;
+        for (int t = 1; t <= maxThreads; t++)
+        {
+            omp_set_num_threads(t);
+            Eigen::setNbThreads(t);
+            double tEigen = measure([&] { C.noalias() = A * B; }, opts).min;
+            double tTask1 = measure([&] { strassenMultParallel(A, B, S, ws, 1); }, opts).min;
+            double tTask2 = measure([&] { strassenMultParallel(A, B, S, ws, 2); }, opts).min;
+            cout << setw(8) << t << setw(12) << tEigen << setw(14) << tTask1 << setw(14) << tTask2 << endl;
+        }
+    }
+
+    return 0;
+}
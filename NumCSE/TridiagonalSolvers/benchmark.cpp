@@ -0,0 +1,114 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "benchmark_stats.hpp"
+#include "tridiagonal.hpp"
+
+using Eigen::ArrayXXd;
+using Eigen::Index;
+using Eigen::VectorXd;
+using std::cout;
+using std::endl;
+using std::setw;
+
+
+/// @brief Prints a line of the table: the time and the bandwidth for the compulsory traffic.
+void report(const std::string& name, double seconds, double bytes)
+{
+    cout << setw(34) << name << setw(14) << seconds * 1e3 << setw(14) << bytes / seconds / 1e9 << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const Index            n = argc > 1 ? std::atol(argv[1]) : 10000000;
+    const BenchmarkOptions opts;  // every row reports the fastest of the timed runs
+#ifdef _OPENMP
+    cout << "OpenMP threads: " << omp_get_max_threads() << endl;
+#endif
+    cout << "Bandwidth counts the compulsory traffic only: the inputs read once and the solution written once" << endl
+         << endl;
+
+    // Single large system, as from a 1D implicit step on a fine grid
+    {
+        const VectorXd a = VectorXd::Constant(n - 1, -1.0);
+        const VectorXd b = VectorXd::Constant(n, 2.5);
+        const VectorXd c = VectorXd::Constant(n - 1, -1.0);
+        const VectorXd d = VectorXd::Random(n);
+        VectorXd       x, work;
+        const double   words = 8.0 * n;
+        auto           reset = [&] { x = d; };
+
+        cout << "One system, n = " << n << endl;
+        cout << setw(34) << "method" << setw(14) << "time [ms]" << setw(14) << "GB/s" << endl;
+
+        // STREAM-like triad as the reference of what the memory delivers
+        VectorXd y = VectorXd::Random(n), z = VectorXd::Random(n);
+        report("triad x = y + 0.5 z (reference)", measure([&] { x.noalias() = y + 0.5 * z; }, opts).min, 3 * words);
+
+        report("Thomas", measure([&] { thomasSolve(a, b, c, x, work); }, opts, reset).min, 5 * words);
+
+        ThomasSolver<double> thomas;
+        thomas.compute(a, b, c);
+        report("Thomas, factorized solve", measure([&] { thomas.solveInPlace(x); }, opts, reset).min, 5 * words);
+
+        report("cyclic reduction", measure([&] { cyclicReductionSolve(a, b, c, x); }, opts, reset).min, 5 * words);
+        report("partition method", measure([&] { partitionSolve(a, b, c, x); }, opts, reset).min, 5 * words);
+    }
+    cout << endl;
+
+    // Many small systems, as from splines through many curves or line-implicit sweeps
+    {
+        const Index batch = 4096, m = 1024;
+        const ArrayXXd a = ArrayXXd::Constant(batch, m - 1, -1.0);
+        const ArrayXXd b = ArrayXXd::Random(batch, m) + 3.0;
+        const ArrayXXd c = ArrayXXd::Constant(batch, m - 1, -1.0);
+        const ArrayXXd d = ArrayXXd::Random(batch, m);
+        ArrayXXd       x, work;
+        const double   words = 8.0 * batch * m;
+
+        cout << batch << " systems, n = " << m << endl;
+        cout << setw(34) << "method" << setw(14) << "time [ms]" << setw(14) << "GB/s" << endl;
+
+        // One system at a time needs the systems contiguous, i.e. the transposed layout
+        std::vector<VectorXd> sa(batch), sb(batch), sc(batch), sd(batch);
+        for (Index k = 0; k < batch; k++)
+        {
+            sa[k] = a.row(k).transpose().matrix();
+            sb[k] = b.row(k).transpose().matrix();
+            sc[k] = c.row(k).transpose().matrix();
+            sd[k] = d.row(k).transpose().matrix();
+        }
+        std::vector<VectorXd> sx;
+        VectorXd              sw;
+        report("Thomas, one system at a time",
+               measure(
+                   [&] {
+                       for (Index k = 0; k < batch; k++)
+                       {
+                           thomasSolve(sa[k], sb[k], sc[k], sx[k], sw);
+                       }
+                   },
+                   opts, [&] { sx = sd; })
+                   .min,
+               5 * words);
+
+        report("Thomas, batched in SIMD lanes",
+               measure([&] { batchedThomasSolve(a, b, c, x, work); }, opts, [&] { x = d; }).min, 5 * words);
+
+        // Same matrix for all systems: the factorization is shared and only the right-hand sides stream
+        ThomasSolver<double> shared;
+        shared.compute(a.row(0).transpose().matrix(), b.row(0).transpose().matrix(), c.row(0).transpose().matrix());
+        report("factorized, shared matrix", measure([&] { shared.solveBatchedInPlace(x); }, opts, [&] { x = d; }).min,
+               2 * words);
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include "tridiagonal.hpp"
+
+using std::cout;
+using std::endl;
+
+using Eigen::ArrayXXd;
+using Eigen::Index;
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+
+/// @brief Assembles the sparse matrix of a tridiagonal system given by its diagonals.
+Eigen::SparseMatrix<double> assemble(const VectorXd& a, const VectorXd& b, const VectorXd& c)
+{
+    const Index                         n = b.size();
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(3 * n);
+    for (Index i = 0; i < n; i++)
+    {
+        triplets.emplace_back(i, i, b(i));
+        if (i < n - 1)
+        {
+            triplets.emplace_back(i + 1, i, a(i));
+            triplets.emplace_back(i, i + 1, c(i));
+        }
+    }
+    Eigen::SparseMatrix<double> A(n, n);
+    A.setFromTriplets(triplets.begin(), triplets.end());
+    return A;
+}
+
+
+int main()
+{
+    // A random diagonally dominant system, checked against SparseLU
+    for (Index n : {1, 2, 3, 5, 64, 1000, 4097})
+    {
+        const VectorXd a = VectorXd::Random(n - 1);
+        const VectorXd c = VectorXd::Random(n - 1);
+        const VectorXd b = VectorXd::Random(n).array() + 3.0;
+        const VectorXd d = VectorXd::Random(n);
+
+        Eigen::SparseMatrix<double>                  A = assemble(a, b, c);
+        Eigen::SparseLU<Eigen::SparseMatrix<double>> lu(A);
+        const VectorXd                               reference = lu.solve(d);
+
+        VectorXd x = d, work;
+        thomasSolve(a, b, c, x, work);
+        assert(x.isApprox(reference) && "Thomas algorithm failed");
+
+        ThomasSolver<double> thomas;
+        thomas.compute(a, b, c);
+        assert(thomas.solve(d).isApprox(reference) && "Factorized Thomas algorithm failed");
+
+        x = d;
+        cyclicReductionSolve(a, b, c, x);
+        assert(x.isApprox(reference) && "Cyclic reduction failed");
+
+        // More partitions than threads exercises the reduced system on one core as well
+        for (int partitions : {1, 2, 3, 7, 16})
+        {
+            x = d;
+            partitionSolve(a, b, c, x, partitions);
+            assert(x.isApprox(reference) && "Partition method failed");
+        }
+    }
+    cout << "Thomas, cyclic reduction and partition method agree with SparseLU" << endl;
+
+    // Pentadiagonal system through the banded LU
+    {
+        const Index n = 500, kl = 2, ku = 3;
+        MatrixXd    A = MatrixXd::Zero(n, n);
+        for (Index i = 0; i < n; i++)
+        {
+            for (Index j = std::max<Index>(0, i - kl); j <= std::min(n - 1, i + ku); j++)
+            {
+                A(i, j) = i == j ? 8.0 : std::sin(double(i + 2 * j));
+            }
+        }
+        const VectorXd       d = VectorXd::Random(n);
+        BandedSolver<double> banded;
+        banded.compute(BandedSolver<double>::toBandStorage(A, kl, ku), kl, ku);
+        assert(banded.solve(d).isApprox(A.partialPivLu().solve(d)) && "Banded LU failed");
+
+        Eigen::SparseMatrix<double> S = A.sparseView();
+        banded.compute(BandedSolver<double>::toBandStorage(S, kl, ku), kl, ku);
+        assert(banded.solve(d).isApprox(A.partialPivLu().solve(d)) && "Banded LU from a sparse matrix failed");
+    }
+    cout << "Banded LU agrees with PartialPivLU" << endl;
+
+    // Natural cubic splines through many curves sampled on the same knots: one matrix, a batch of right-hand
+    // sides. The second derivatives M solve h_{i-1} M_{i-1} + 2 (h_{i-1} + h_i) M_i + h_i M_{i+1} = 6 (s_i - s_{i-1})
+    // at the interior knots, with s_i the slope of interval i.
+    {
+        const Index    knots = 200, curves = 3000;
+        const VectorXd t     = VectorXd::LinSpaced(knots, 0.0, 1.0).array().pow(1.5);  // non-uniform
+        const VectorXd h     = t.tail(knots - 1) - t.head(knots - 1);
+        const Index    n     = knots - 2;
+
+        const VectorXd a = h.segment(1, n - 1);
+        const VectorXd b = 2.0 * (h.head(n) + h.tail(n));
+        const VectorXd c = h.segment(1, n - 1);
+
+        ArrayXXd Y(curves, knots);
+        for (Index k = 0; k < curves; k++)
+        {
+            Y.row(k) = (double(k % 17 + 1) * t.array()).sin().transpose();
+        }
+        ArrayXXd slopes = (Y.rightCols(knots - 1) - Y.leftCols(knots - 1)).rowwise() / h.array().transpose();
+        ArrayXXd M      = 6.0 * (slopes.rightCols(n) - slopes.leftCols(n));
+
+        ThomasSolver<double> spline;
+        spline.compute(a, b, c);
+        ArrayXXd reference = M;
+        spline.solveBatchedInPlace(M);
+        for (Index k = 0; k < curves; k += 997)
+        {
+            VectorXd rhs = reference.row(k).transpose().matrix();
+            assert(M.row(k).transpose().matrix().isApprox(spline.solve(rhs)) && "Batched spline solve failed");
+        }
+    }
+    cout << "Batched spline solve agrees with the single solves" << endl;
+
+    // Implicit Euler steps of u_t = k u_xx with a different diffusivity per system: a batch of matrices
+    {
+        const Index batch = 5000, n = 257;
+        const double dt = 1e-3, dx = 1.0 / (n + 1);
+        const ArrayXXd kappa = (ArrayXXd::Random(batch, 1) + 1.5).replicate(1, n);
+        const ArrayXXd r     = kappa * dt / (dx * dx);
+        const ArrayXXd a     = -r.leftCols(n - 1);
+        const ArrayXXd b     = 1.0 + 2.0 * r;
+        const ArrayXXd c     = -r.rightCols(n - 1);
+        ArrayXXd       u     = ArrayXXd::Random(batch, n), work;
+
+        ArrayXXd next = u;
+        batchedThomasSolve(a, b, c, next, work);
+        for (Index k = 0; k < batch; k += 1249)
+        {
+            VectorXd x = u.row(k).transpose().matrix(), w;
+            thomasSolve<double>(a.row(k).transpose().matrix(), b.row(k).transpose().matrix(), c.row(k).transpose().matrix(), x, w);
+            assert(next.row(k).transpose().matrix().isApprox(x) && "Batched Thomas algorithm failed");
+        }
+        // The implicit step is a contraction in the max norm
+        assert(next.abs().maxCoeff() <= u.abs().maxCoeff());
+    }
+    cout << "Batched Thomas algorithm agrees with the single solves" << endl;
+
+    return 0;
+}
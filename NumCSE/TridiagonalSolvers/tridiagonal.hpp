@@ -0,0 +1,549 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+// Tridiagonal systems are stored as three diagonals, as in LAPACK's gtsv:
+//   a(i) = A(i + 1, i), size n - 1, the sub-diagonal
+//   b(i) = A(i, i),     size n,     the diagonal
+//   c(i) = A(i, i + 1), size n - 1, the super-diagonal
+// None of the solvers pivot, so the matrix should be diagonally dominant or symmetric positive definite,
+// which covers spline and implicit time-step matrices. The hot loops index raw pointers: Eigen's operator()
+// checks bounds unless NDEBUG is set, and the Makefiles keep asserts on for the demos.
+
+template<typename T>
+using TriVector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+/// @brief A batch of tridiagonal coefficients or right-hand sides, one system per row and one unknown per
+/// column. Column-major storage puts the same unknown of all systems next to each other, so the batched
+/// solvers sweep the unknowns and run the systems in SIMD lanes.
+template<typename T>
+using BatchArray = Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+
+/// @brief Thomas algorithm split into an O(n) factorization and an O(n) solve, so a matrix that does not
+/// change, e.g. a constant implicit time step, is factorized once.
+/// @tparam T is the scalar type.
+template<typename T>
+class ThomasSolver
+{
+  public:
+    /// @brief Factorizes the tridiagonal matrix.
+    /// @param a is the sub-diagonal.
+    /// @param b is the diagonal.
+    /// @param c is the super-diagonal.
+    void compute(const TriVector<T>& a, const TriVector<T>& b, const TriVector<T>& c)
+    {
+        const Eigen::Index n = b.size();
+        assert(a.size() == n - 1 && c.size() == n - 1);
+        sub = a;
+        cp.resize(n - 1);
+        invDenom.resize(n);
+        invDenom(0) = T(1) / b(0);
+        for (Eigen::Index i = 0; i < n - 1; i++)
+        {
+            cp(i)           = c(i) * invDenom(i);
+            invDenom(i + 1) = T(1) / (b(i + 1) - a(i) * cp(i));
+        }
+    }
+
+    /// @brief Solves A x = d in place.
+    /// @param d is the right-hand side on entry and the solution on exit.
+    void solveInPlace(TriVector<T>& d) const
+    {
+        const Eigen::Index n = invDenom.size();
+        assert(d.size() == n);
+        const T* l = sub.data();
+        const T* u = cp.data();
+        const T* p = invDenom.data();
+        T*       x = d.data();
+        x[0] *= p[0];
+        for (Eigen::Index i = 1; i < n; i++)
+        {
+            x[i] = (x[i] - l[i - 1] * x[i - 1]) * p[i];
+        }
+        for (Eigen::Index i = n - 2; i >= 0; i--)
+        {
+            x[i] -= u[i] * x[i + 1];
+        }
+    }
+
+    /// @brief Solves A x = rhs.
+    /// @param rhs is the right-hand side.
+    /// @return The solution.
+    TriVector<T> solve(const TriVector<T>& rhs) const
+    {
+        TriVector<T> x = rhs;
+        solveInPlace(x);
+        return x;
+    }
+
+    /// @brief Solves A X = D for a batch of right-hand sides sharing the matrix, e.g. splines through many
+    /// curves on the same knots. Each step updates a whole column, i.e. one unknown of every system.
+    /// @param D is the batch of right-hand sides, one per row, on entry and the solutions on exit.
+    void solveBatchedInPlace(BatchArray<T>& D) const
+    {
+        const Eigen::Index n = invDenom.size();
+        assert(D.cols() == n);
+        D.col(0) *= invDenom(0);
+        for (Eigen::Index i = 1; i < n; i++)
+        {
+            D.col(i) = (D.col(i) - sub(i - 1) * D.col(i - 1)) * invDenom(i);
+        }
+        for (Eigen::Index i = n - 2; i >= 0; i--)
+        {
+            D.col(i) -= cp(i) * D.col(i + 1);
+        }
+    }
+
+    Eigen::Index size() const { return invDenom.size(); }
+
+  private:
+    TriVector<T> sub;       // sub-diagonal
+    TriVector<T> cp;        // super-diagonal after elimination
+    TriVector<T> invDenom;  // inverse pivots
+};
+
+
+/// @brief Solves a tridiagonal system with the Thomas algorithm, 8n flops and one pass down and up.
+/// @param a is the sub-diagonal.
+/// @param b is the diagonal.
+/// @param c is the super-diagonal.
+/// @param d is the right-hand side on entry and the solution on exit.
+/// @param work is scratch of size n - 1, resized if needed.
+template<typename T>
+void thomasSolve(const TriVector<T>& a, const TriVector<T>& b, const TriVector<T>& c, TriVector<T>& d, TriVector<T>& work)
+{
+    const Eigen::Index n = b.size();
+    assert(a.size() == n - 1 && c.size() == n - 1 && d.size() == n);
+    work.resize(n - 1);
+    const T* pa = a.data();
+    const T* pb = b.data();
+    const T* pc = c.data();
+    T*       x  = d.data();
+    T*       w  = work.data();
+    T        denom = pb[0];
+    x[0] /= denom;
+    for (Eigen::Index i = 1; i < n; i++)
+    {
+        w[i - 1] = pc[i - 1] / denom;
+        denom    = pb[i] - pa[i - 1] * w[i - 1];
+        x[i]     = (x[i] - pa[i - 1] * x[i - 1]) / denom;
+    }
+    for (Eigen::Index i = n - 2; i >= 0; i--)
+    {
+        x[i] -= w[i] * x[i + 1];
+    }
+}
+
+
+/// @brief Solves a tridiagonal system with cyclic reduction. Each level eliminates the odd unknowns of the
+/// remaining system, so after log2(n) levels a single equation is left; back substitution walks the levels
+/// down again. It does about 2x the flops of Thomas, but the equations of a level are independent and are
+/// split over the OpenMP threads.
+/// @param a is the sub-diagonal.
+/// @param b is the diagonal.
+/// @param c is the super-diagonal.
+/// @param d is the right-hand side on entry and the solution on exit.
+template<typename T>
+void cyclicReductionSolve(const TriVector<T>& a, const TriVector<T>& b, const TriVector<T>& c, TriVector<T>& d)
+{
+    const Eigen::Index n = b.size();
+    assert(a.size() == n - 1 && c.size() == n - 1 && d.size() == n);
+
+    // Full-length copies: lo(i) couples row i to x(i - s) and up(i) to x(i + s) at stride s
+    TriVector<T> lo(n), diag = b, up(n), rhs = d;
+    lo(0)     = T(0);
+    up(n - 1) = T(0);
+    lo.tail(n - 1) = a;
+    up.head(n - 1) = c;
+
+    Eigen::Index top = 1;
+    while (2 * top <= n)
+    {
+        top *= 2;
+    }
+
+    T* pl = lo.data();
+    T* pd = diag.data();
+    T* pu = up.data();
+    T* pr = rhs.data();
+    T* x  = d.data();
+
+    #pragma omp parallel
+    {
+        // Reduction: at stride s the equations i = 2s - 1 mod 2s absorb their neighbours at i - s and i + s
+        for (Eigen::Index s = 1; 2 * s <= n; s *= 2)
+        {
+            #pragma omp for schedule(static)
+            for (Eigen::Index i = 2 * s - 1; i < n; i += 2 * s)
+            {
+                const Eigen::Index l     = i - s;
+                const Eigen::Index r     = i + s;
+                const T            alpha = -pl[i] / pd[l];
+                T                  upNew = T(0);
+                pd[i] += alpha * pu[l];
+                pr[i] += alpha * pr[l];
+                pl[i]  = alpha * pl[l];
+                if (r < n)
+                {
+                    const T gamma = -pu[i] / pd[r];
+                    pd[i] += gamma * pl[r];
+                    pr[i] += gamma * pr[r];
+                    upNew  = gamma * pu[r];
+                }
+                pu[i] = upNew;
+            }
+        }
+
+        // Back substitution: at stride s the equations i = s - 1 mod 2s only couple to solved unknowns
+        for (Eigen::Index s = top; s >= 1; s /= 2)
+        {
+            #pragma omp for schedule(static)
+            for (Eigen::Index i = s - 1; i < n; i += 2 * s)
+            {
+                T value = pr[i];
+                if (i - s >= 0)
+                {
+                    value -= pl[i] * x[i - s];
+                }
+                if (i + s < n)
+                {
+                    value -= pu[i] * x[i + s];
+                }
+                x[i] = value / pd[i];
+            }
+        }
+    }
+}
+
+
+/// @brief Solves a tridiagonal system with the partition method. The rows are split into contiguous blocks,
+/// one per thread. Each block is eliminated independently, down and up, until every row depends only on the
+/// first and last unknown of its block; those 2p unknowns form a tridiagonal reduced system that is solved with
+/// Thomas. Every block then recovers its interior unknowns, again in parallel. Each thread streams its block
+/// twice, so the method keeps Thomas' O(n) memory traffic while using all threads.
+/// @param a is the sub-diagonal.
+/// @param b is the diagonal.
+/// @param c is the super-diagonal.
+/// @param d is the right-hand side on entry and the solution on exit.
+/// @param partitions is the number of blocks, 0 for one per OpenMP thread.
+template<typename T>
+void partitionSolve(const TriVector<T>& a, const TriVector<T>& b, const TriVector<T>& c, TriVector<T>& d, int partitions = 0)
+{
+    const Eigen::Index n = b.size();
+    assert(a.size() == n - 1 && c.size() == n - 1 && d.size() == n);
+    if (partitions <= 0)
+    {
+#ifdef _OPENMP
+        partitions = omp_get_max_threads();
+#else
+        partitions = 1;
+#endif
+    }
+    // Blocks need a first and a last row
+    const Eigen::Index p = std::max<Eigen::Index>(1, std::min<Eigen::Index>(partitions, n / 2));
+    if (p == 1)
+    {
+        TriVector<T> work;
+        thomasSolve(a, b, c, d, work);
+        return;
+    }
+    auto first = [n, p](Eigen::Index k) { return k * n / p; };
+
+    // Row i of a block reads f(i) x_first + x(i) + g(i) x_last = d(i) after elimination; at the block ends
+    // f and g hold the couplings to the neighbouring blocks instead
+    TriVector<T> fx(n), lx(n);
+    TriVector<T> ra(2 * p - 1), rb = TriVector<T>::Ones(2 * p), rc(2 * p - 1), rd(2 * p);
+
+    const T* pa = a.data();
+    const T* pb = b.data();
+    const T* pc = c.data();
+    T*       x  = d.data();
+    T*       f  = fx.data();
+    T*       g  = lx.data();
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index s = first(k);
+        const Eigen::Index e = first(k + 1) - 1;
+
+        // Downward pass: eliminate the sub-diagonal, filling in the column of x_first
+        for (Eigen::Index i = s; i <= std::min(s + 1, e); i++)
+        {
+            const T inv = T(1) / pb[i];
+            f[i]        = (i > 0 ? pa[i - 1] : T(0)) * inv;
+            g[i]        = (i < n - 1 ? pc[i] : T(0)) * inv;
+            x[i]       *= inv;
+        }
+        for (Eigen::Index i = s + 2; i <= e; i++)
+        {
+            const T inv = T(1) / (pb[i] - pa[i - 1] * g[i - 1]);
+            x[i]        = (x[i] - pa[i - 1] * x[i - 1]) * inv;
+            f[i]        = -pa[i - 1] * f[i - 1] * inv;
+            g[i]        = (i < n - 1 ? pc[i] : T(0)) * inv;
+        }
+
+        // Upward pass: eliminate the super-diagonal, filling in the column of x_last
+        for (Eigen::Index i = e - 2; i > s; i--)
+        {
+            x[i] -= g[i] * x[i + 1];
+            f[i] -= g[i] * f[i + 1];
+            g[i]  = -g[i] * g[i + 1];
+        }
+        if (e - s >= 2)
+        {
+            const T inv = T(1) / (T(1) - g[s] * f[s + 1]);
+            x[s]        = (x[s] - g[s] * x[s + 1]) * inv;
+            f[s]       *= inv;
+            g[s]        = -g[s] * g[s + 1] * inv;
+        }
+
+        // Reduced system in (first_0, last_0, first_1, last_1, ...)
+        rd(2 * k)     = x[s];
+        rd(2 * k + 1) = x[e];
+        if (k > 0)
+        {
+            ra(2 * k - 1) = f[s];
+        }
+        rc(2 * k) = g[s];
+        ra(2 * k) = f[e];
+        if (k < p - 1)
+        {
+            rc(2 * k + 1) = g[e];
+        }
+    }
+
+    TriVector<T> work;
+    thomasSolve(ra, rb, rc, rd, work);
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < p; k++)
+    {
+        const Eigen::Index s  = first(k);
+        const Eigen::Index e  = first(k + 1) - 1;
+        const T            xs = rd(2 * k);
+        const T            xe = rd(2 * k + 1);
+        for (Eigen::Index i = s + 1; i < e; i++)
+        {
+            x[i] -= f[i] * xs + g[i] * xe;
+        }
+        x[s] = xs;
+        x[e] = xe;
+    }
+}
+
+
+/// @brief Number of systems a thread sweeps together in the batched solver. The previous column of the chunk
+/// stays in L1 while the next one streams in.
+inline constexpr Eigen::Index kBatchChunk = 512;
+
+/// @brief Solves a batch of independent tridiagonal systems of the same size, one per row of the arrays. The
+/// sweep runs over the unknowns, and every step updates the same unknown of all systems of a chunk in one
+/// vectorized loop, so thousands of small systems run in SIMD lanes; chunks go to the OpenMP threads.
+/// @param a is the batch of sub-diagonals, (batch, n - 1).
+/// @param b is the batch of diagonals, (batch, n).
+/// @param c is the batch of super-diagonals, (batch, n - 1).
+/// @param d is the batch of right-hand sides on entry and the solutions on exit, (batch, n).
+/// @param work is scratch of size (batch, n - 1), resized if needed.
+template<typename T>
+void batchedThomasSolve(const BatchArray<T>& a, const BatchArray<T>& b, const BatchArray<T>& c, BatchArray<T>& d, BatchArray<T>& work)
+{
+    const Eigen::Index batch = b.rows();
+    const Eigen::Index n     = b.cols();
+    assert(a.rows() == batch && c.rows() == batch && d.rows() == batch);
+    assert(a.cols() == n - 1 && c.cols() == n - 1 && d.cols() == n);
+    work.resize(batch, n - 1);
+
+    // Columns are batch apart, and a chunk is contiguous within a column
+    const T* pa = a.data();
+    const T* pb = b.data();
+    const T* pc = c.data();
+    T*       pd = d.data();
+    T*       pw = work.data();
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index r = 0; r < batch; r += kBatchChunk)
+    {
+        const Eigen::Index w = std::min(kBatchChunk, batch - r);
+
+        {
+            const T* b0 = pb + r;
+            T*       d0 = pd + r;
+            #pragma omp simd
+            for (Eigen::Index j = 0; j < w; j++)
+            {
+                d0[j] /= b0[j];
+            }
+        }
+        for (Eigen::Index i = 1; i < n; i++)
+        {
+            const T* ai = pa + (i - 1) * batch + r;
+            const T* bi = pb + i * batch + r;
+            const T* bp = pb + (i - 1) * batch + r;
+            const T* cp = pc + (i - 1) * batch + r;
+            const T* wp = i > 1 ? pw + (i - 2) * batch + r : nullptr;
+            const T* ap = i > 1 ? pa + (i - 2) * batch + r : nullptr;
+            T*       wi = pw + (i - 1) * batch + r;
+            T*       dp = pd + (i - 1) * batch + r;
+            T*       di = pd + i * batch + r;
+            // Recomputing the previous pivot from its coefficients saves storing the pivots
+            if (i == 1)
+            {
+                #pragma omp simd
+                for (Eigen::Index j = 0; j < w; j++)
+                {
+                    wi[j] = cp[j] / bp[j];
+                    di[j] = (di[j] - ai[j] * dp[j]) / (bi[j] - ai[j] * wi[j]);
+                }
+            }
+            else
+            {
+                #pragma omp simd
+                for (Eigen::Index j = 0; j < w; j++)
+                {
+                    wi[j] = cp[j] / (bp[j] - ap[j] * wp[j]);
+                    di[j] = (di[j] - ai[j] * dp[j]) / (bi[j] - ai[j] * wi[j]);
+                }
+            }
+        }
+        for (Eigen::Index i = n - 2; i >= 0; i--)
+        {
+            const T* wi = pw + i * batch + r;
+            const T* dn = pd + (i + 1) * batch + r;
+            T*       di = pd + i * batch + r;
+            #pragma omp simd
+            for (Eigen::Index j = 0; j < w; j++)
+            {
+                di[j] -= wi[j] * dn[j];
+            }
+        }
+    }
+}
+
+
+/// @brief LU factorization of a banded matrix without pivoting in LAPACK band storage: AB(ku + i - j, j) = A(i, j)
+/// for max(0, j - ku) <= i <= min(n - 1, j + kl). Factorization costs O(n kl ku) and a solve O(n (kl + ku)), and
+/// the factors overwrite the band, so no fill-in beyond it. Tridiagonal is kl = ku = 1; pentadiagonal systems
+/// from fourth-order stencils or splines are kl = ku = 2.
+/// @tparam T is the scalar type.
+template<typename T>
+class BandedSolver
+{
+  public:
+    using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+    /// @brief Copies the band of a dense matrix into band storage.
+    /// @param A is the matrix.
+    /// @param kl is the number of sub-diagonals.
+    /// @param ku is the number of super-diagonals.
+    /// @return The band storage, (kl + ku + 1, n).
+    template<typename Derived>
+    static Matrix toBandStorage(const Eigen::MatrixBase<Derived>& A, Eigen::Index kl, Eigen::Index ku)
+    {
+        const Eigen::Index n  = A.cols();
+        Matrix             AB = Matrix::Zero(kl + ku + 1, n);
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            for (Eigen::Index i = std::max<Eigen::Index>(0, j - ku); i <= std::min(n - 1, j + kl); i++)
+            {
+                AB(ku + i - j, j) = A(i, j);
+            }
+        }
+        return AB;
+    }
+
+    /// @brief Copies the non-zeros of a sparse matrix into band storage; entries outside the band are an error.
+    template<int Options>
+    static Matrix toBandStorage(const Eigen::SparseMatrix<T, Options>& A, Eigen::Index kl, Eigen::Index ku)
+    {
+        Matrix AB = Matrix::Zero(kl + ku + 1, A.cols());
+        for (Eigen::Index outer = 0; outer < A.outerSize(); outer++)
+        {
+            for (typename Eigen::SparseMatrix<T, Options>::InnerIterator it(A, outer); it; ++it)
+            {
+                assert(it.row() - it.col() <= kl && it.col() - it.row() <= ku);
+                AB(ku + it.row() - it.col(), it.col()) = it.value();
+            }
+        }
+        return AB;
+    }
+
+    /// @brief Factorizes the matrix A = L U in place of the band.
+    /// @param AB is the matrix in band storage.
+    /// @param kl is the number of sub-diagonals.
+    /// @param ku is the number of super-diagonals.
+    void compute(const Matrix& AB, Eigen::Index kl, Eigen::Index ku)
+    {
+        assert(AB.rows() == kl + ku + 1);
+        this->kl = kl;
+        this->ku = ku;
+        LU       = AB;
+        const Eigen::Index n = LU.cols();
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            const T            inv  = T(1) / at(j, j);
+            const Eigen::Index last = std::min(n - 1, j + kl);
+            for (Eigen::Index i = j + 1; i <= last; i++)
+            {
+                at(i, j) *= inv;
+            }
+            for (Eigen::Index k = j + 1; k <= std::min(n - 1, j + ku); k++)
+            {
+                const T ujk = at(j, k);
+                for (Eigen::Index i = j + 1; i <= last; i++)
+                {
+                    at(i, k) -= at(i, j) * ujk;
+                }
+            }
+        }
+    }
+
+    /// @brief Solves A x = d in place with the factors.
+    /// @param d is the right-hand side on entry and the solution on exit.
+    void solveInPlace(TriVector<T>& d) const
+    {
+        const Eigen::Index n = LU.cols();
+        assert(d.size() == n);
+        for (Eigen::Index j = 0; j < n; j++)
+        {
+            for (Eigen::Index i = j + 1; i <= std::min(n - 1, j + kl); i++)
+            {
+                d(i) -= at(i, j) * d(j);
+            }
+        }
+        for (Eigen::Index j = n - 1; j >= 0; j--)
+        {
+            d(j) /= at(j, j);
+            for (Eigen::Index i = std::max<Eigen::Index>(0, j - ku); i < j; i++)
+            {
+                d(i) -= at(i, j) * d(j);
+            }
+        }
+    }
+
+    /// @brief Solves A x = rhs.
+    /// @param rhs is the right-hand side.
+    /// @return The solution.
+    TriVector<T> solve(const TriVector<T>& rhs) const
+    {
+        TriVector<T> x = rhs;
+        solveInPlace(x);
+        return x;
+    }
+
+  private:
+    Matrix       LU;
+    Eigen::Index kl = 0;
+    Eigen::Index ku = 0;
+
+    T&       at(Eigen::Index i, Eigen::Index j) { return LU(ku + i - j, j); }
+    const T& at(Eigen::Index i, Eigen::Index j) const { return LU(ku + i - j, j); }
+};